@@ -8,10 +8,10 @@
 namespace brlib
 {
 
-    EntryBase::EntryBase(EntryFrom from, const std::tm& tm, const str& _narr,
-                         long dr, long cr, long bal):
+    EntryBase::EntryBase(EntryFrom from, day_t day, str _narr,
+                         paise_t dr, paise_t cr, paise_t bal):
         m_entryFrom(from),
-        date(tm), narr(std::move(_narr)), debit(dr),
+        date(day), narr(std::move(_narr)), debit(dr),
         credit(cr), balance(bal)
     {
         if (from == EntryFrom::Bank)
@@ -20,42 +20,31 @@ namespace brlib
         }
     }
 
-    void EntryBase::printDate(ostringstream& os) const
+    void EntryBase::printDay(ostringstream& os, day_t day)
     {
-        os << std::put_time(&date, "%d-%m-%Y\0");
+        const std::tm t = tmFromDays(day);
+        os << std::put_time(&t, "%d-%m-%Y\0");
     }
 
-    void EntryBase::printNarr(ostringstream& os) const { os << narr; }
-
-    void EntryBase::printMoney(ostringstream& os, moneyType mt) const
+    void EntryBase::printAmount(ostringstream& os, paise_t paise)
     {
-        const long m = mt == moneyType::bal ? balance : mt == moneyType::dr ? debit :
-                                                                              credit;
-        os << std::setw(12) << std::right << std::put_money(m);
+        os << std::setw(12) << std::right << std::put_money(paise);
     }
 
-    void EntryBase::printDebit(ostringstream& os) const
-    {
-        printMoney(os, moneyType::dr);
-    }
+    void EntryBase::printDate(ostringstream& os) const { printDay(os, date); }
 
-    void EntryBase::printCredit(ostringstream& os) const
-    {
-        printMoney(os, moneyType::cr);
-    }
+    void EntryBase::printNarr(ostringstream& os) const { os << narr; }
+
+    void EntryBase::printDebit(ostringstream& os) const { printAmount(os, debit); }
+
+    void EntryBase::printCredit(ostringstream& os) const { printAmount(os, credit); }
 
     void EntryBase::printBalance(ostringstream& os) const
     {
-        printMoney(os, moneyType::bal);
+        printAmount(os, balance);
     }
 
-    long EntryBase::toPaise(const str& s)
-    {
-        std::istringstream ss(s);
-        double d;
-        ss >> d;
-        return long(d * 100);
-    }
+    paise_t EntryBase::toPaise(std::string_view s) { return parse::toPaise(s); }
 
     void EntryBase::print(ostringstream& os) const
     {
@@ -71,7 +60,7 @@ namespace brlib
         printBalance(os);
     }
 
-    void EntryBase::validate(long debit, long credit)
+    void EntryBase::validate(paise_t debit, paise_t credit)
     {
         if (debit > 0 && credit > 0)
         {
@@ -87,8 +76,7 @@ namespace brlib
 
     bool EntryBase::operator==(const EntryBase& rhs) const
     {
-        bool dateEqual = dt_equal(date, rhs.date);
-        return dateEqual && credit == rhs.credit && debit == rhs.debit;
+        return date == rhs.date && credit == rhs.credit && debit == rhs.debit;
     }
 
 } // namespace brlib
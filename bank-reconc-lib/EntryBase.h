@@ -3,6 +3,7 @@
 
 #include "brlib_common.h"
 #include <ctime>
+#include <string_view>
 #include <utility>
 
 namespace brlib
@@ -16,14 +17,14 @@ namespace brlib
             Bank,
             Books
         };
-        EntryBase(EntryFrom from, const std::tm& tm, const str& _narr, long dr,
-                  long cr = 0, long bal = 0);
+        EntryBase(EntryFrom from, day_t day, str _narr, paise_t dr,
+                  paise_t cr = 0, paise_t bal = 0);
         EntryBase():
-            EntryBase(EntryFrom::Bank, {}, "", 0) {}
+            EntryBase(EntryFrom::Bank, 0, "", 0) {}
 
-        std::tm date;
+        day_t date;
         str narr;
-        long debit, credit, balance;
+        paise_t debit, credit, balance;
 
         void printDate(ostringstream&) const;
         void printNarr(ostringstream&) const;
@@ -32,24 +33,20 @@ namespace brlib
         void printBalance(ostringstream&) const;
 
         void print(ostringstream&) const;
+
+        /* shared with EntryStore's print members */
+        static void printDay(ostringstream&, day_t day);
+        static void printAmount(ostringstream&, paise_t paise);
         [[nodiscard]] EntryFrom entryFrom() const;
 
         bool operator==(const EntryBase& rhs) const;
 
-        static long toPaise(const str&);
+        static paise_t toPaise(std::string_view);
         //  static EntryBase fromString(const str &, const EntryFrom &, const
         //  EntryParseOptions &options);
-        static void validate(long debit, long credit);
+        static void validate(paise_t debit, paise_t credit);
 
     private:
-        enum moneyType
-        {
-            dr = 0,
-            cr = 1,
-            bal = 2
-        };
-        void printMoney(ostringstream&, moneyType) const;
-
         EntryFrom m_entryFrom;
         static constexpr char books_dt_fmt[] = "%d-%m-%Y\0";
         static constexpr char bank_dt_fmt[] = "%d/%m/%y\0"; // 01/01/21
@@ -1,20 +1,33 @@
-#include "EntryBase.h"
 #include <algorithm>
 #include <sstream>
 
 #include "EntryMatch.h"
+#include "EntryStore.h"
 #include <stdexcept>
 #include <utility>
 
 namespace brlib
 {
 
-    EntryMatch::EntryMatch(vec<EntryPointer> _data, sp<entry_vec> passedBankVec,
-                           sp<entry_vec> passedBooksVec, bool isManual):
+    EntryMatch::EntryMatch(vec<EntryPointer> _data, sp<EntryStore> passedBankVec,
+                           sp<EntryStore> passedBooksVec, bool isManual):
         m_data(std::move(_data)),
         m_bankPassedVec(std::move(passedBankVec)),
         m_booksPassedVec(std::move(passedBooksVec)), m_isManual(isManual)
     {
+        auto before = [](const EntryPointer& lhs, const EntryPointer& rhs) {
+            return lhs.entryFor != rhs.entryFor ? lhs.entryFor < rhs.entryFor :
+                                                  lhs.entryIdx < rhs.entryIdx;
+        };
+        if (!std::is_sorted(m_data.begin(), m_data.end(), before))
+        {
+            std::sort(m_data.begin(), m_data.end(), before);
+        }
+        for (const EntryPointer& ep : m_data)
+        {
+            m_banks += ep.entryFor == EntryPointer::For::Bank;
+        }
+        m_sumsKnown = m_data.empty();
         if (!isManual)
         {
             m_isValid = true;
@@ -25,98 +38,121 @@ namespace brlib
 
     bool EntryMatch::bankIdxExists(entry_vec_sz_t entry_idx) const
     {
-        return findIdx(EntryPointer::For::Bank, entry_idx) != m_data.end();
+        return contains(EntryPointer::For::Bank, entry_idx);
     }
 
     bool EntryMatch::booksIdxExists(entry_vec_sz_t entry_idx) const
     {
-        return findIdx(EntryPointer::For::Books, entry_idx) != m_data.end();
+        return contains(EntryPointer::For::Books, entry_idx);
     }
 
     vec<EntryPointer>::const_iterator
       EntryMatch::findIdx(EntryPointer::For entryFor, entry_vec_sz_t idx) const
     {
-        return std::find_if(m_data.begin(), m_data.end(), [&](const EntryPointer p) {
-            return p.entryFor == entryFor && p.entryIdx == idx;
+        const auto first = entryFor == EntryPointer::For::Bank ? m_data.begin() :
+                                                                 m_data.begin() + m_banks;
+        const auto last = entryFor == EntryPointer::For::Bank ? m_data.begin() + m_banks :
+                                                                m_data.end();
+        return std::lower_bound(first, last, idx, [](const EntryPointer& p, entry_vec_sz_t i) {
+            return p.entryIdx < i;
         });
     }
 
-    unsigned long EntryMatch::banksSize() const
+    bool EntryMatch::contains(EntryPointer::For entryFor, entry_vec_sz_t idx) const
     {
-        return std::count_if(m_data.begin(), m_data.end(), [&](const EntryPointer p) {
-            return p.entryFor == EntryPointer::For::Bank;
-        });
+        const auto it = findIdx(entryFor, idx);
+        return it != m_data.end() && it->entryFor == entryFor && it->entryIdx == idx;
     }
 
-    unsigned long EntryMatch::booksSize() const
+    bool EntryMatch::insert(EntryPointer::For entryFor, entry_vec_sz_t idx)
     {
-        return std::count_if(m_data.begin(), m_data.end(), [&](const EntryPointer p) {
-            return p.entryFor == EntryPointer::For::Books;
-        });
+        const auto it = findIdx(entryFor, idx);
+        if (it != m_data.end() && it->entryFor == entryFor && it->entryIdx == idx)
+        {
+            return false;
+        }
+        const EntryPointer ep(idx, entryFor);
+        m_data.insert(it, ep);
+        m_banks += entryFor == EntryPointer::For::Bank;
+        addToSums(ep, 1);
+        return true;
+    }
+
+    void EntryMatch::erase(EntryPointer::For entryFor, entry_vec_sz_t idx)
+    {
+        const auto it = findIdx(entryFor, idx);
+        if (it == m_data.end() || it->entryFor != entryFor || it->entryIdx != idx)
+        {
+            return;
+        }
+        addToSums(*it, -1);
+        m_banks -= entryFor == EntryPointer::For::Bank;
+        m_data.erase(it);
+    }
+
+    void EntryMatch::knowSums() const
+    {
+        if (m_sumsKnown)
+        {
+            return;
+        }
+        m_sumsKnown = true;
+        for (const EntryPointer& ep : m_data)
+        {
+            addToSums(ep, 1);
+        }
     }
 
+    void EntryMatch::addToSums(const EntryPointer& ep, paise_t sign) const
+    {
+        if (!m_sumsKnown)
+        {
+            return;
+        }
+        if (ep.entryFor == EntryPointer::For::Bank)
+        {
+            m_bankDebits += sign * m_bankPassedVec->debit(ep.entryIdx);
+            m_bankCredits += sign * m_bankPassedVec->credit(ep.entryIdx);
+        }
+        else
+        {
+            m_booksTotal += sign * m_booksPassedVec->amount(ep.entryIdx);
+        }
+    }
+
+    unsigned long EntryMatch::banksSize() const { return m_banks; }
+
+    unsigned long EntryMatch::booksSize() const { return m_data.size() - m_banks; }
+
     unsigned long EntryMatch::setsTotalSize() const { return m_data.size(); }
 
-    long EntryMatch::debitSum() const { return amountSum(); }
+    paise_t EntryMatch::debitSum() const { return amountSum(); }
 
-    long EntryMatch::creditSum() const { return amountSum(false); }
+    paise_t EntryMatch::creditSum() const { return amountSum(false); }
 
-    long EntryMatch::amountSum(bool forDebit) const
+    paise_t EntryMatch::amountSum(bool forDebit) const
     {
         checkBankVecSize();
-        long sum = 0;
-        for (const decltype(m_data)::value_type& entryPointer : m_data)
-        {
-            if (entryPointer.entryFor == EntryPointer::For::Bank)
-            {
-                const auto& bankIdx = entryPointer.entryIdx;
-                const EntryBase& entry = m_bankPassedVec->at(bankIdx);
-                if (!forDebit)
-                {
-                    sum += entry.credit;
-                }
-                else
-                {
-                    sum += entry.debit;
-                }
-            }
-        }
-        return sum;
+        knowSums();
+        return forDebit ? m_bankDebits : m_bankCredits;
     }
 
-    long EntryMatch::banksSum() const
+    /* one of debit / credit is 0, so an entry's amount is their sum */
+    paise_t EntryMatch::banksSum() const
     {
         checkBankVecSize();
-        long sum = 0;
-        for (const decltype(m_data)::value_type& entryPointer : m_data)
-        {
-            if (entryPointer.entryFor == EntryPointer::For::Bank)
-            {
-                const auto& bankIdx = entryPointer.entryIdx;
-                const EntryBase& entry = m_bankPassedVec->at(bankIdx);
-                sum += !entry.debit ? entry.credit : entry.debit;
-            }
-        }
-        return sum;
+        knowSums();
+        return m_bankDebits + m_bankCredits;
     }
 
-    long EntryMatch::booksSum() const
+    paise_t EntryMatch::booksSum() const
     {
         checkBooksVecSize();
-        long sum = 0;
-        for (const decltype(m_data)::value_type& entryPointer : m_data)
-        {
-            if (entryPointer.entryFor == EntryPointer::For::Books)
-            {
-                const auto& booksIdx = entryPointer.entryIdx;
-                const EntryBase& entry = m_booksPassedVec->at(booksIdx);
-                sum += !entry.debit ? entry.credit : entry.debit;
-            }
-        }
-        return sum;
+        knowSums();
+        return m_booksTotal;
     }
 
-    void EntryMatch::printMoney(unsigned long money, std::ostringstream& oss)
+    void EntryMatch::printMoney(paise_t money, std::ostringstream& oss)
     {
         oss.imbue(std::cout.getloc());
         oss << std::setw(12) << std::right << std::put_money(money);
@@ -127,12 +163,11 @@ namespace brlib
                                     const results_t& results)
     {
         checkBankVecSize();
-        if (!insertionCheck(bankIdx, results.missingInBook, m_bankPassedVec))
+        if (!insertionCheck(bankIdx, results.bankMissing, m_bankPassedVec))
         {
             return false;
         }
-        m_data.push_back(EntryPointer(bankIdx, EntryPointer::For::Bank));
-        return true;
+        return insert(EntryPointer::For::Bank, bankIdx);
     }
 
     /* insert booksVecIdx into set for a valid match. */
@@ -140,17 +175,15 @@ namespace brlib
                                      const results_t& results)
     {
         checkBooksVecSize();
-        if (!insertionCheck(bookIdx, results.missingInBank, m_booksPassedVec))
+        if (!insertionCheck(bookIdx, results.booksMissing, m_booksPassedVec))
         {
             return false;
         }
-        m_data.push_back(EntryPointer(bookIdx, EntryPointer::For::Books));
-        return true;
+        return insert(EntryPointer::For::Books, bookIdx);
     }
 
-    bool EntryMatch::insertionCheck(entry_vec_sz_t i,
-                                    const vec<entry_vec_sz_t>& lookupVec,
-                                    sp<entry_vec> passedEntries)
+    bool EntryMatch::insertionCheck(entry_vec_sz_t i, const vec<bool>& missing,
+                                    const sp<EntryStore>& passedEntries)
     {
         if (i >= passedEntries->size())
         {
@@ -158,33 +191,24 @@ namespace brlib
                       << std::endl;
             return false;
         }
-        if (m_isManual)
+        /* manual matches only take entries still missing on the other side */
+        if (m_isManual && (i >= missing.size() || !missing[i]))
         {
-            auto endIt = lookupVec.cend();
-            auto it = std::find(lookupVec.cbegin(), endIt, i);
-            if (it == endIt)
-            {
-                std::cerr << "EntryMatch insertionCheck() i not found in lookupVec" << i
-                          << std::endl;
-                return false;
-            }
+            std::cerr << "EntryMatch insertionCheck() i not missing" << i << std::endl;
+            return false;
         }
         return true;
     }
 
     bool EntryMatch::containsBankIdx(entry_vec_sz_t i) const
     {
-        return std::find_if(m_data.begin(), m_data.end(), [&](const EntryPointer p) {
-                   return p.entryFor == EntryPointer::For::Bank && p.entryIdx == i;
-               }) != m_data.end();
+        return contains(EntryPointer::For::Bank, i);
     }
 
     bool EntryMatch::containsBooksIdx(entry_vec_sz_t i) const
     {
-        return std::find_if(m_data.begin(), m_data.end(), [&](const EntryPointer p) {
-                   return p.entryFor == EntryPointer::For::Books && p.entryIdx == i;
-               }) != m_data.end();
-    };
+        return contains(EntryPointer::For::Books, i);
+    }
 
     void EntryMatch::printData() const
     {
@@ -209,53 +233,19 @@ namespace brlib
 
     void EntryMatch::eraseBankIdx(entry_vec_sz_t bankIdx)
     {
-        erase_if(m_data, [&](EntryPointer& ep) {
-            return ep.entryFor == EntryPointer::For::Bank && ep.entryIdx == bankIdx;
-        });
+        erase(EntryPointer::For::Bank, bankIdx);
     }
 
     void EntryMatch::eraseBooksIdx(entry_vec_sz_t booksIdx)
     {
-        erase_if(m_data, [&](EntryPointer& ep) {
-            return ep.entryFor == EntryPointer::For::Books && ep.entryIdx == booksIdx;
-        });
-    }
-
-    const EntryBase& EntryMatch::entryForBankIdx(entry_vec_sz_t bankIdx) const
-    {
-        return m_bankPassedVec->at(bankIdx);
-    }
-    const EntryBase& EntryMatch::entryForBooksIdx(entry_vec_sz_t booksIdx) const
-    {
-        return m_booksPassedVec->at(booksIdx);
+        erase(EntryPointer::For::Books, booksIdx);
     }
 
     bool EntryMatch::isValid()
     {
-        long bankSum = 0;
-        long booksSum = 0;
-        for (const EntryPointer& ep : m_data)
-        {
-            if (ep.entryFor == EntryPointer::For::Bank)
-            {
-                if (!containsBankIdx(ep.entryIdx))
-                {
-                    return false;
-                }
-                const EntryBase& entry = entryForBankIdx(ep.entryIdx);
-                bankSum += !entry.debit ? entry.credit : entry.debit;
-            }
-            else
-            {
-                if (!containsBooksIdx(ep.entryIdx))
-                {
-                    return false;
-                }
-                const EntryBase& entry = entryForBooksIdx(ep.entryIdx);
-                booksSum += !entry.debit ? entry.credit : entry.debit;
-            }
-        }
-        m_isValid = (bankSum > 0) && (booksSum == bankSum);
+        knowSums();
+        const paise_t bankSum = m_bankDebits + m_bankCredits;
+        m_isValid = (bankSum > 0) && (m_booksTotal == bankSum);
         return m_isValid;
     }
 
@@ -274,12 +264,9 @@ namespace brlib
     EntryMatch::entry_set EntryMatch::banksIndices() const
     {
         entry_set s;
-        for (const auto& ep : m_data)
+        for (auto it = m_data.begin(); it != m_data.begin() + m_banks; ++it)
         {
-            if (ep.entryFor == EntryPointer::For::Bank)
-            {
-                s.insert(ep.entryIdx);
-            }
+            s.insert(s.end(), it->entryIdx);
         }
         return s;
     }
@@ -287,12 +274,9 @@ namespace brlib
     EntryMatch::entry_set EntryMatch::booksSet() const
     {
         entry_set s;
-        for (const auto& ep : m_data)
+        for (auto it = m_data.begin() + m_banks; it != m_data.end(); ++it)
         {
-            if (ep.entryFor == EntryPointer::For::Books)
-            {
-                s.insert(ep.entryIdx);
-            }
+            s.insert(s.end(), it->entryIdx);
         }
         return s;
     }
@@ -42,8 +42,8 @@ namespace brlib
         };
 
         using entry_set = std::set<entry_vec_sz_t>;
-        explicit EntryMatch(vec<EntryPointer> _data, sp<entry_vec> passedBankVec,
-                            sp<entry_vec> passedBooksVec, bool isManual = false);
+        explicit EntryMatch(vec<EntryPointer> _data, sp<EntryStore> passedBankVec,
+                            sp<EntryStore> passedBooksVec, bool isManual = false);
 
         [[nodiscard]] bool isManual() const;
         [[nodiscard]] bool bankIdxExists(entry_vec_sz_t entry_idx) const;
@@ -51,11 +51,11 @@ namespace brlib
         [[nodiscard]] unsigned long banksSize() const;
         [[nodiscard]] unsigned long booksSize() const;
         [[nodiscard]] unsigned long setsTotalSize() const;
-        [[nodiscard]] long debitSum() const;
-        [[nodiscard]] long creditSum() const;
-        [[nodiscard]] long amountSum(bool forDebit = true) const;
-        [[nodiscard]] long banksSum() const;
-        [[nodiscard]] long booksSum() const;
+        [[nodiscard]] paise_t debitSum() const;
+        [[nodiscard]] paise_t creditSum() const;
+        [[nodiscard]] paise_t amountSum(bool forDebit = true) const;
+        [[nodiscard]] paise_t banksSum() const;
+        [[nodiscard]] paise_t booksSum() const;
         [[nodiscard]] bool containsBankIdx(entry_vec_sz_t i) const;
         [[nodiscard]] bool containsBooksIdx(entry_vec_sz_t i) const;
         bool insertIntoBank(entry_vec_sz_t i, const results_t& results);
@@ -69,37 +69,50 @@ namespace brlib
         inline void clear()
         {
             m_data.clear();
+            m_banks = 0;
+            m_bankDebits = m_bankCredits = m_booksTotal = 0;
+            m_sumsKnown = true;
             m_isValid = false;
         };
 
         void printData() const;
 
         [[nodiscard]] bool isValid();
-        static void printMoney(unsigned long money, std::ostringstream& oss);
+        static void printMoney(paise_t money, std::ostringstream& oss);
 
+        /* bank pointers, then books pointers, each by ascending index */
         [[nodiscard]] const vec<EntryPointer>& data() const;
 
     private:
-        bool insertionCheck(entry_vec_sz_t i, const vec<entry_vec_sz_t>& lookupVec,
-                            sp<entry_vec> passedEntries);
-
-        [[nodiscard]] const EntryBase& entryForBankIdx(entry_vec_sz_t bankIdx) const;
-
-        [[nodiscard]] const EntryBase&
-          entryForBooksIdx(entry_vec_sz_t booksIdx) const;
+        bool insertionCheck(entry_vec_sz_t i, const vec<bool>& missing,
+                            const sp<EntryStore>& passedEntries);
 
+        /* where idx is, or would go, in the run of entryFor's pointers */
         [[nodiscard]] vec<EntryPointer>::const_iterator
-          findIdx(EntryPointer::For entryFor, entry_vec_sz_t) const;
+          findIdx(EntryPointer::For entryFor, entry_vec_sz_t idx) const;
+        [[nodiscard]] bool contains(EntryPointer::For entryFor, entry_vec_sz_t idx) const;
+        /* keeps m_data ordered and the running sums current; false if present */
+        bool insert(EntryPointer::For entryFor, entry_vec_sz_t idx);
+        void erase(EntryPointer::For entryFor, entry_vec_sz_t idx);
+        void addToSums(const EntryPointer& ep, paise_t sign) const;
+        /* sums of a match built from a pointer list are added up when first
+         * asked for, so loading many matches doesn't read every amount */
+        void knowSums() const;
 
         void checkBankVecSize() const;
         void checkBooksVecSize() const;
 
-        sp<entry_vec> m_bankPassedVec;
-        sp<entry_vec> m_booksPassedVec;
-        bool m_isValid;
+        sp<EntryStore> m_bankPassedVec;
+        sp<EntryStore> m_booksPassedVec;
+        bool m_isValid{false};
         bool m_isManual;
 
         vec<EntryPointer> m_data;
+        /* bank pointers at the front of m_data */
+        std::size_t m_banks{0};
+        /* running sums over m_data, so no query walks it */
+        mutable paise_t m_bankDebits{0}, m_bankCredits{0}, m_booksTotal{0};
+        mutable bool m_sumsKnown{true};
     };
 } // namespace brlib
 
@@ -0,0 +1,204 @@
+#include <stdexcept>
+#include <utility>
+
+#include "EntryStore.h"
+
+namespace brlib
+{
+
+    EntryStore::EntryStore(EntryBase::EntryFrom from, const Columns& columns,
+                           sp<const void> keepAlive):
+        m_from(from),
+        m_cols(columns), m_keepAlive(std::move(keepAlive))
+    {
+        const size_type rows = columns.days.size();
+        if (columns.debits.size() != rows || columns.credits.size() != rows ||
+            columns.balances.size() != rows || columns.narrEnds.size() != rows)
+        {
+            throw std::invalid_argument("entry columns differ in length");
+        }
+        /* narr() takes each narration between the previous end and its own */
+        std::size_t begin = 0;
+        for (const std::size_t end : columns.narrEnds)
+        {
+            if (end < begin || end > columns.narrArena.size())
+            {
+                throw std::invalid_argument("narrations run past their arena");
+            }
+            begin = end;
+        }
+    }
+
+    EntryStore::EntryStore(const EntryStore& rhs):
+        m_from(rhs.m_from),
+        m_days(rhs.m_days), m_debits(rhs.m_debits), m_credits(rhs.m_credits),
+        m_balances(rhs.m_balances), m_narrEnds(rhs.m_narrEnds),
+        m_narrArena(rhs.m_narrArena), m_cols(rhs.m_cols), m_keepAlive(rhs.m_keepAlive)
+    {
+        rebind();
+    }
+
+    EntryStore::EntryStore(EntryStore&& rhs) noexcept:
+        m_from(rhs.m_from),
+        m_days(std::move(rhs.m_days)), m_debits(std::move(rhs.m_debits)),
+        m_credits(std::move(rhs.m_credits)), m_balances(std::move(rhs.m_balances)),
+        m_narrEnds(std::move(rhs.m_narrEnds)), m_narrArena(std::move(rhs.m_narrArena)),
+        m_cols(rhs.m_cols), m_keepAlive(std::move(rhs.m_keepAlive))
+    {
+        rebind();
+        rhs.clear();
+    }
+
+    EntryStore& EntryStore::operator=(const EntryStore& rhs)
+    {
+        if (this != &rhs)
+        {
+            *this = EntryStore(rhs);
+        }
+        return *this;
+    }
+
+    EntryStore& EntryStore::operator=(EntryStore&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            m_from = rhs.m_from;
+            m_days = std::move(rhs.m_days);
+            m_debits = std::move(rhs.m_debits);
+            m_credits = std::move(rhs.m_credits);
+            m_balances = std::move(rhs.m_balances);
+            m_narrEnds = std::move(rhs.m_narrEnds);
+            m_narrArena = std::move(rhs.m_narrArena);
+            m_cols = rhs.m_cols;
+            m_keepAlive = std::move(rhs.m_keepAlive);
+            rebind();
+            rhs.clear();
+        }
+        return *this;
+    }
+
+    void EntryStore::own()
+    {
+        if (!m_keepAlive)
+        {
+            return;
+        }
+        m_days.assign(m_cols.days.begin(), m_cols.days.end());
+        m_debits.assign(m_cols.debits.begin(), m_cols.debits.end());
+        m_credits.assign(m_cols.credits.begin(), m_cols.credits.end());
+        m_balances.assign(m_cols.balances.begin(), m_cols.balances.end());
+        m_narrEnds.assign(m_cols.narrEnds.begin(), m_cols.narrEnds.end());
+        m_narrArena.assign(m_cols.narrArena);
+        m_keepAlive.reset();
+    }
+
+    void EntryStore::rebind()
+    {
+        if (!m_keepAlive)
+        {
+            m_cols = {m_days, m_debits, m_credits, m_balances, m_narrEnds, m_narrArena};
+        }
+    }
+
+    void EntryStore::push_back(const EntryBase& entry)
+    {
+        own();
+        m_from = entry.entryFrom();
+        m_days.push_back(entry.date);
+        m_debits.push_back(entry.debit);
+        m_credits.push_back(entry.credit);
+        m_balances.push_back(entry.balance);
+        m_narrArena.append(entry.narr);
+        m_narrEnds.push_back(m_narrArena.size());
+        rebind();
+    }
+
+    void EntryStore::append(const EntryStore& rhs)
+    {
+        own();
+        m_from = rhs.m_from;
+        const Columns& cols = rhs.m_cols;
+        m_days.insert(m_days.end(), cols.days.begin(), cols.days.end());
+        m_debits.insert(m_debits.end(), cols.debits.begin(), cols.debits.end());
+        m_credits.insert(m_credits.end(), cols.credits.begin(), cols.credits.end());
+        m_balances.insert(m_balances.end(), cols.balances.begin(), cols.balances.end());
+        const std::size_t offset = m_narrArena.size();
+        m_narrArena.append(cols.narrArena);
+        m_narrEnds.reserve(m_narrEnds.size() + cols.narrEnds.size());
+        for (const std::size_t end : cols.narrEnds)
+        {
+            m_narrEnds.push_back(offset + end);
+        }
+        rebind();
+    }
+
+    void EntryStore::reserve(size_type rows, std::size_t narrBytes)
+    {
+        own();
+        m_days.reserve(rows);
+        m_debits.reserve(rows);
+        m_credits.reserve(rows);
+        m_balances.reserve(rows);
+        m_narrEnds.reserve(rows);
+        m_narrArena.reserve(narrBytes);
+        rebind();
+    }
+
+    void EntryStore::clear()
+    {
+        m_keepAlive.reset();
+        m_days.clear();
+        m_debits.clear();
+        m_credits.clear();
+        m_balances.clear();
+        m_narrEnds.clear();
+        m_narrArena.clear();
+        rebind();
+    }
+
+    std::string_view EntryStore::narr(size_type i) const
+    {
+        const std::size_t begin = i ? m_cols.narrEnds[i - 1] : 0;
+        return m_cols.narrArena.substr(begin, m_cols.narrEnds[i] - begin);
+    }
+
+    void EntryStore::permute(const vec<size_type>& order)
+    {
+        EntryStore sorted(m_from);
+        sorted.reserve(order.size(), m_cols.narrArena.size());
+        for (const size_type i : order)
+        {
+            sorted.m_days.push_back(m_cols.days[i]);
+            sorted.m_debits.push_back(m_cols.debits[i]);
+            sorted.m_credits.push_back(m_cols.credits[i]);
+            sorted.m_balances.push_back(m_cols.balances[i]);
+            sorted.m_narrArena.append(narr(i));
+            sorted.m_narrEnds.push_back(sorted.m_narrArena.size());
+        }
+        sorted.rebind();
+        *this = std::move(sorted);
+    }
+
+    void EntryStore::printDate(size_type i, ostringstream& os) const
+    {
+        EntryBase::printDay(os, m_cols.days[i]);
+    }
+
+    void EntryStore::printNarr(size_type i, ostringstream& os) const { os << narr(i); }
+
+    void EntryStore::printDebit(size_type i, ostringstream& os) const
+    {
+        EntryBase::printAmount(os, m_cols.debits[i]);
+    }
+
+    void EntryStore::printCredit(size_type i, ostringstream& os) const
+    {
+        EntryBase::printAmount(os, m_cols.credits[i]);
+    }
+
+    void EntryStore::printBalance(size_type i, ostringstream& os) const
+    {
+        EntryBase::printAmount(os, m_cols.balances[i]);
+    }
+
+} // namespace brlib
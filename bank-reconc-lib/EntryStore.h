@@ -0,0 +1,112 @@
+#ifndef BRLIB_ENTRYSTORE_H
+#define BRLIB_ENTRYSTORE_H
+
+#include <span>
+#include <string_view>
+
+#include "EntryBase.h"
+#include "brlib_common.h"
+
+namespace brlib
+{
+
+    /** parsed entries of one file, stored column-wise: day numbers, debit /
+     * credit / balance in paise, and narrations packed end to end in one arena.
+     * the whole store comes from one side (bank or books), so that flag is kept
+     * once. loops that touch a single field read it through the column spans.
+     * the columns may also live in memory the store doesn't own, such as a
+     * mapped session snapshot; the first change copies them in. */
+    class EntryStore
+    {
+    public:
+        using size_type = entry_vec_sz_t;
+
+        /* every column at once, in the layout the store keeps them */
+        struct Columns
+        {
+            std::span<const day_t> days;
+            std::span<const paise_t> debits, credits, balances;
+            /* narration i is narrArena[narrEnds[i - 1], narrEnds[i]) */
+            std::span<const std::size_t> narrEnds;
+            std::string_view narrArena;
+        };
+
+        explicit EntryStore(EntryBase::EntryFrom from = EntryBase::EntryFrom::Bank):
+            m_from(from) {}
+
+        /* a store reading columns from memory kept valid by keepAlive. throws
+         * std::invalid_argument if the columns disagree on the row count or the
+         * narration ends decrease or run past the arena. */
+        EntryStore(EntryBase::EntryFrom from, const Columns& columns,
+                   sp<const void> keepAlive);
+
+        EntryStore(const EntryStore& rhs);
+        EntryStore(EntryStore&& rhs) noexcept;
+        EntryStore& operator=(const EntryStore& rhs);
+        EntryStore& operator=(EntryStore&& rhs) noexcept;
+
+        void push_back(const EntryBase& entry);
+        /* rows of rhs after the rows of this store */
+        void append(const EntryStore& rhs);
+        void reserve(size_type rows, std::size_t narrBytes = 0);
+        void clear();
+
+        [[nodiscard]] size_type size() const { return m_cols.days.size(); }
+        [[nodiscard]] bool empty() const { return m_cols.days.empty(); }
+        [[nodiscard]] EntryBase::EntryFrom entryFrom() const { return m_from; }
+        /* true while the columns are read from memory the store doesn't own */
+        [[nodiscard]] bool isMapped() const { return m_keepAlive != nullptr; }
+
+        [[nodiscard]] day_t day(size_type i) const { return m_cols.days[i]; }
+        [[nodiscard]] paise_t debit(size_type i) const { return m_cols.debits[i]; }
+        [[nodiscard]] paise_t credit(size_type i) const { return m_cols.credits[i]; }
+        [[nodiscard]] paise_t balance(size_type i) const { return m_cols.balances[i]; }
+        [[nodiscard]] std::string_view narr(size_type i) const;
+
+        /* whichever of debit / credit is set */
+        [[nodiscard]] paise_t amount(size_type i) const
+        {
+            return !m_cols.debits[i] ? m_cols.credits[i] : m_cols.debits[i];
+        }
+
+        [[nodiscard]] std::span<const day_t> days() const { return m_cols.days; }
+        [[nodiscard]] std::span<const paise_t> debits() const { return m_cols.debits; }
+        [[nodiscard]] std::span<const paise_t> credits() const { return m_cols.credits; }
+        [[nodiscard]] std::span<const paise_t> balances() const { return m_cols.balances; }
+        [[nodiscard]] const Columns& columns() const { return m_cols; }
+
+        /* reorder rows so that row i becomes row order[i] of the current store */
+        void permute(const vec<size_type>& order);
+
+        void printDate(size_type i, ostringstream& os) const;
+        void printNarr(size_type i, ostringstream& os) const;
+        void printDebit(size_type i, ostringstream& os) const;
+        void printCredit(size_type i, ostringstream& os) const;
+        void printBalance(size_type i, ostringstream& os) const;
+
+    private:
+        /* copy mapped columns into the vectors before they change */
+        void own();
+        /* point m_cols at the vectors after they changed */
+        void rebind();
+
+        EntryBase::EntryFrom m_from;
+
+        vec<day_t> m_days;
+        vec<paise_t> m_debits;
+        vec<paise_t> m_credits;
+        vec<paise_t> m_balances;
+
+        /* narration i is m_narrArena[m_narrEnds[i - 1], m_narrEnds[i]) */
+        vec<std::size_t> m_narrEnds;
+        str m_narrArena;
+
+        /* what every accessor reads: the vectors above, or mapped memory held
+         * by m_keepAlive */
+        Columns m_cols;
+        sp<const void> m_keepAlive;
+    };
+
+} // namespace brlib
+
+#endif // BRLIB_ENTRYSTORE_H
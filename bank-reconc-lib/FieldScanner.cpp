@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BRLIB_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+#include "FieldScanner.h"
+
+#if defined(BRLIB_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BRLIB_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BRLIB_TARGET_AVX2
+#endif
+
+namespace brlib::parse
+{
+
+    namespace
+    {
+        ByteMasks classifyScalar(const char* p, std::size_t n, char delimChar)
+        {
+            ByteMasks m;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                const std::uint32_t bit = std::uint32_t(1) << i;
+                if (p[i] == delimChar)
+                {
+                    m.delim |= bit;
+                }
+                else if (p[i] == '"')
+                {
+                    m.quote |= bit;
+                }
+            }
+            return m;
+        }
+
+#if defined(BRLIB_SCAN_X86)
+        /* two 16 byte halves; SSE2 is always there on x86-64 */
+        ByteMasks classifySse2(const char* p, char delimChar)
+        {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+            auto mask = [&](char c) {
+                const __m128i v = _mm_set1_epi8(c);
+                const auto l = std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, v)));
+                const auto h = std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, v)));
+                return l | (h << 16);
+            };
+            return {mask(delimChar), mask('"')};
+        }
+
+        BRLIB_TARGET_AVX2 ByteMasks classifyAvx2(const char* p, char delimChar)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i delim = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(delimChar));
+            const __m256i quote = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"'));
+            return {std::uint32_t(_mm256_movemask_epi8(delim)),
+                    std::uint32_t(_mm256_movemask_epi8(quote))};
+        }
+
+        bool cpuHasAvx2()
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int regs[4];
+            __cpuid(regs, 0);
+            if (regs[0] < 7)
+            {
+                return false;
+            }
+            __cpuid(regs, 1);
+            /* osxsave and avx, and the os saving ymm state */
+            const bool osAvx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) &&
+                               (_xgetbv(0) & 6) == 6;
+            __cpuidex(regs, 7, 0);
+            return osAvx && (regs[1] & (1 << 5));
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        ScanLevel detectScanLevel()
+        {
+#if defined(BRLIB_SCAN_X86)
+            return cpuHasAvx2() ? ScanLevel::AVX2 : ScanLevel::SSE2;
+#else
+            return ScanLevel::Scalar;
+#endif
+        }
+    } // namespace
+
+    ScanLevel scanLevel()
+    {
+        static const ScanLevel level = detectScanLevel();
+        return level;
+    }
+
+    ByteMasks classifyBlock(const char* p, std::size_t n, char delimChar, ScanLevel level)
+    {
+#if defined(BRLIB_SCAN_X86)
+        if (level != ScanLevel::Scalar)
+        {
+            /* a short tail is copied out, so loads never run past the row; the
+             * zero padding matches none of the classes */
+            char padded[scanBlockSize] = {};
+            if (n < scanBlockSize)
+            {
+                std::memcpy(padded, p, n);
+                p = padded;
+            }
+            return level == ScanLevel::AVX2 ? classifyAvx2(p, delimChar) :
+                                              classifySse2(p, delimChar);
+        }
+#endif
+        return classifyScalar(p, std::min(n, scanBlockSize), delimChar);
+    }
+
+    ByteMasks classifyBlock(const char* p, std::size_t n, char delimChar)
+    {
+        return classifyBlock(p, n, delimChar, scanLevel());
+    }
+
+    void scanDelims(std::string_view row, char delimChar, vec<std::size_t>& out,
+                    ScanLevel level)
+    {
+        /* a quote opens or closes a quoted run; delims inside one don't count,
+         * and an unbalanced quote runs to the end of the row */
+        bool inQuote = false;
+        for (std::size_t base = 0; base < row.size(); base += scanBlockSize)
+        {
+            const ByteMasks m =
+              classifyBlock(row.data() + base, row.size() - base, delimChar, level);
+            if (!m.quote && !inQuote)
+            {
+                for (std::uint32_t bits = m.delim; bits; bits &= bits - 1)
+                {
+                    out.push_back(base + std::countr_zero(bits));
+                }
+                continue;
+            }
+            for (std::uint32_t bits = m.delim | m.quote; bits; bits &= bits - 1)
+            {
+                const int i = std::countr_zero(bits);
+                if (m.quote >> i & 1)
+                {
+                    inQuote = !inQuote;
+                }
+                else if (!inQuote)
+                {
+                    out.push_back(base + i);
+                }
+            }
+        }
+    }
+
+    void scanDelims(std::string_view row, char delimChar, vec<std::size_t>& out)
+    {
+        scanDelims(row, delimChar, out, scanLevel());
+    }
+
+} // namespace brlib::parse
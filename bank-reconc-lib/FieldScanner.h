@@ -0,0 +1,42 @@
+#ifndef BRLIB_FIELDSCANNER_H
+#define BRLIB_FIELDSCANNER_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "brlib_common.h"
+
+namespace brlib::parse
+{
+
+    /* bit i set where byte i of a block is a delim or a quote. */
+    struct ByteMasks
+    {
+        std::uint32_t delim{0}, quote{0};
+    };
+
+    enum class ScanLevel
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    static constexpr std::size_t scanBlockSize = 32;
+
+    /* widest level this cpu runs; checked once. */
+    ScanLevel scanLevel();
+
+    /** classify the first n (at most scanBlockSize) bytes at p. the
+     * level-less overload uses scanLevel(). */
+    ByteMasks classifyBlock(const char* p, std::size_t n, char delimChar);
+    ByteMasks classifyBlock(const char* p, std::size_t n, char delimChar, ScanLevel level);
+
+    /* append the positions of delims outside quotes in row to out. */
+    void scanDelims(std::string_view row, char delimChar, vec<std::size_t>& out);
+    void scanDelims(std::string_view row, char delimChar, vec<std::size_t>& out,
+                    ScanLevel level);
+
+} // namespace brlib::parse
+
+#endif // BRLIB_FIELDSCANNER_H
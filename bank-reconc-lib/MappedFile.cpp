@@ -0,0 +1,175 @@
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+namespace brlib
+{
+
+#if defined(_WIN32)
+    MappedFile::MappedFile(const str& path)
+    {
+        HANDLE file = CreateFileA(path.data(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw FileOpenError("couldn't open " + path);
+        }
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file, &sz))
+        {
+            CloseHandle(file);
+            throw FileOpenError("couldn't stat " + path);
+        }
+        m_file = file;
+        m_size = static_cast<std::size_t>(sz.QuadPart);
+        /* a zero-length file can't be mapped; leave it as an empty view */
+        if (!m_size)
+        {
+            return;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            unmap();
+            throw FileOpenError("couldn't map " + path);
+        }
+        m_mapping = mapping;
+        m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data)
+        {
+            unmap();
+            throw FileOpenError("couldn't map " + path);
+        }
+    }
+
+    bool syncFile(const str& path)
+    {
+        HANDLE file = CreateFileA(path.data(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        const bool synced = FlushFileBuffers(file) != 0;
+        CloseHandle(file);
+        return synced;
+    }
+
+    void MappedFile::unmap()
+    {
+        if (m_data)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping)
+        {
+            CloseHandle(m_mapping);
+        }
+        if (m_file)
+        {
+            CloseHandle(m_file);
+        }
+        m_data = nullptr;
+        m_mapping = m_file = nullptr;
+        m_size = 0;
+    }
+#else
+    MappedFile::MappedFile(const str& path)
+    {
+        const int fd = ::open(path.data(), O_RDONLY);
+        if (fd == -1)
+        {
+            throw FileOpenError("couldn't open " + path);
+        }
+        struct stat st
+        {
+        };
+        if (::fstat(fd, &st) == -1)
+        {
+            ::close(fd);
+            throw FileOpenError("couldn't stat " + path);
+        }
+        m_size = static_cast<std::size_t>(st.st_size);
+        /* a zero-length file can't be mapped; leave it as an empty view */
+        if (m_size)
+        {
+            void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                m_size = 0;
+                throw FileOpenError("couldn't map " + path);
+            }
+            /* statements are read front to back, once */
+            ::madvise(p, m_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char*>(p);
+        }
+        /* the mapping holds its own reference to the file */
+        ::close(fd);
+    }
+
+    bool syncFile(const str& path)
+    {
+        /* read-only, so directories open too; fsync doesn't need write access */
+        const int fd = ::open(path.data(), O_RDONLY);
+        if (fd == -1)
+        {
+            return false;
+        }
+        const bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        return synced;
+    }
+
+    void MappedFile::unmap()
+    {
+        if (m_data)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+
+    MappedFile::~MappedFile() { unmap(); }
+
+    MappedFile::MappedFile(MappedFile&& rhs) noexcept:
+        m_data(std::exchange(rhs.m_data, nullptr)),
+        m_size(std::exchange(rhs.m_size, 0))
+#if defined(_WIN32)
+        ,
+        m_file(std::exchange(rhs.m_file, nullptr)),
+        m_mapping(std::exchange(rhs.m_mapping, nullptr))
+#endif
+    {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            unmap();
+            m_data = std::exchange(rhs.m_data, nullptr);
+            m_size = std::exchange(rhs.m_size, 0);
+#if defined(_WIN32)
+            m_file = std::exchange(rhs.m_file, nullptr);
+            m_mapping = std::exchange(rhs.m_mapping, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+} // namespace brlib
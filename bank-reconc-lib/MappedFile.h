@@ -0,0 +1,53 @@
+#ifndef BRLIB_MAPPEDFILE_H
+#define BRLIB_MAPPEDFILE_H
+
+#include <string_view>
+
+#include "brlib_common.h"
+
+namespace brlib
+{
+
+    class FileOpenError : public std::runtime_error
+    {
+    public:
+        explicit FileOpenError(const str& s):
+            std::runtime_error(s) {}
+    };
+
+    /** read-only mapping of a whole file. the view stays valid for as long as
+     * the object lives; moving transfers the mapping. */
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const str& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& rhs) noexcept;
+        MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+        [[nodiscard]] const char* data() const { return m_data; }
+        [[nodiscard]] std::size_t size() const { return m_size; }
+        [[nodiscard]] std::string_view view() const { return {m_data, m_size}; }
+
+    private:
+        void unmap();
+
+        const char* m_data{nullptr};
+        std::size_t m_size{0};
+#if defined(_WIN32)
+        void* m_file{nullptr};
+        void* m_mapping{nullptr};
+#endif
+    };
+
+    /* flush what has been written to the file or directory at path through to
+     * the disk; false if it couldn't be opened or flushed. directories can't
+     * be flushed this way on Windows. */
+    bool syncFile(const str& path);
+
+} // namespace brlib
+
+#endif // BRLIB_MAPPEDFILE_H
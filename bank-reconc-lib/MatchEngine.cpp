@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <tuple>
+
+#include "MatchEngine.h"
+
+namespace brlib
+{
+
+    MatchEngine::MatchEngine(const EntryStore& books, const vec<entry_vec_sz_t>& booksRows):
+        m_next(books.size(), npos)
+    {
+        sizeFor(booksRows.size());
+        for (const entry_vec_sz_t i : booksRows)
+        {
+            add(books, i);
+        }
+    }
+
+    void MatchEngine::sizeFor(std::size_t rows)
+    {
+        /* keep the load factor under 0.5, so probe sequences stay short. */
+        const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(rows * 2, 16));
+        m_slots.resize(capacity);
+        m_mask = capacity - 1;
+    }
+
+    void MatchEngine::add(const EntryStore& books, entry_vec_sz_t i)
+    {
+        Slot& slot = *slotFor(keyOf(books, i), true);
+        if (slot.head == npos)
+        {
+            slot.head = i;
+        }
+        else
+        {
+            m_next[slot.tail] = i;
+        }
+        slot.tail = i;
+    }
+
+    entry_vec_sz_t MatchEngine::take(const EntryStore& entries, entry_vec_sz_t i)
+    {
+        Slot* slot = slotFor(keyOf(entries, i), false);
+        if (!slot || slot->head == npos)
+        {
+            return npos;
+        }
+        const entry_vec_sz_t idx = slot->head;
+        slot->head = m_next[idx];
+        return idx;
+    }
+
+    MatchEngine::Key MatchEngine::keyOf(const EntryStore& entries, entry_vec_sz_t i)
+    {
+        return {entries.day(i), entries.debit(i), entries.credit(i)};
+    }
+
+    std::uint64_t MatchEngine::hash(const Key& key)
+    {
+        /* splitmix64 finaliser over the combined fields */
+        std::uint64_t h = std::uint64_t(std::uint32_t(key.day)) * 0x9e3779b97f4a7c15ULL;
+        h ^= std::uint64_t(key.debit) + 0x632be59bd9b4e019ULL + (h << 6) + (h >> 2);
+        h ^= std::uint64_t(key.credit) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    /* find the slot for key; claim an empty one for a new key only on insert,
+     * so lookups of unknown keys never grow the table. */
+    MatchEngine::Slot* MatchEngine::slotFor(const Key& key, bool insert)
+    {
+        std::size_t pos = hash(key) & m_mask;
+        while (m_slots[pos].used && !(m_slots[pos].key == key))
+        {
+            pos = (pos + 1) & m_mask;
+        }
+        Slot& slot = m_slots[pos];
+        if (!slot.used)
+        {
+            if (!insert)
+            {
+                return nullptr;
+            }
+            slot.used = true;
+            slot.key = key;
+        }
+        return &slot;
+    }
+
+    DateWindowEngine::DateWindowEngine(const EntryStore& books, vec<entry_vec_sz_t> booksRows,
+                                       day_t daysEarly, day_t daysLate):
+        m_daysEarly(daysEarly),
+        m_daysLate(daysLate), m_order(std::move(booksRows))
+    {
+        std::sort(m_order.begin(), m_order.end(), [&](entry_vec_sz_t lhs, entry_vec_sz_t rhs) {
+            return std::make_tuple(books.debit(lhs), books.credit(lhs), books.day(lhs), lhs) <
+                   std::make_tuple(books.debit(rhs), books.credit(rhs), books.day(rhs), rhs);
+        });
+
+        const std::size_t n = m_order.size();
+        m_days.resize(n);
+        m_next.resize(n + 1);
+        m_prev.resize(n + 1);
+        std::iota(m_next.begin(), m_next.end(), 0);
+        std::iota(m_prev.begin(), m_prev.end(), 0);
+
+        const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(n * 2, 16));
+        m_buckets.resize(capacity);
+        m_mask = capacity - 1;
+        for (std::size_t p = 0; p < n;)
+        {
+            const paise_t debit = books.debit(m_order[p]);
+            const paise_t credit = books.credit(m_order[p]);
+            std::size_t pos = MatchEngine::hash({0, debit, credit}) & m_mask;
+            while (m_buckets[pos].used)
+            {
+                pos = (pos + 1) & m_mask;
+            }
+            Bucket& bucket = m_buckets[pos];
+            bucket = {debit, credit, p, p, true};
+            for (; p < n && books.debit(m_order[p]) == debit &&
+                   books.credit(m_order[p]) == credit;
+                 ++p)
+            {
+                m_days[p] = books.day(m_order[p]);
+            }
+            bucket.end = p;
+        }
+    }
+
+    const DateWindowEngine::Bucket* DateWindowEngine::bucketFor(paise_t debit, paise_t credit) const
+    {
+        std::size_t pos = MatchEngine::hash({0, debit, credit}) & m_mask;
+        for (; m_buckets[pos].used; pos = (pos + 1) & m_mask)
+        {
+            if (m_buckets[pos].debit == debit && m_buckets[pos].credit == credit)
+            {
+                return &m_buckets[pos];
+            }
+        }
+        return nullptr;
+    }
+
+    std::size_t DateWindowEngine::nextFree(std::size_t pos)
+    {
+        while (m_next[pos] != pos)
+        {
+            m_next[pos] = m_next[m_next[pos]];
+            pos = m_next[pos];
+        }
+        return pos;
+    }
+
+    std::size_t DateWindowEngine::prevFree(std::size_t pos)
+    {
+        while (m_prev[pos] != pos)
+        {
+            m_prev[pos] = m_prev[m_prev[pos]];
+            pos = m_prev[pos];
+        }
+        return pos ? pos - 1 : npos;
+    }
+
+    void DateWindowEngine::consume(std::size_t pos)
+    {
+        m_next[pos] = pos + 1;
+        m_prev[pos + 1] = pos;
+    }
+
+    entry_vec_sz_t DateWindowEngine::take(const EntryStore& entries, entry_vec_sz_t i)
+    {
+        const Bucket* bucket = bucketFor(entries.debit(i), entries.credit(i));
+        if (!bucket)
+        {
+            return npos;
+        }
+        const day_t day = entries.day(i);
+        const auto first = m_days.begin() + std::ptrdiff_t(bucket->begin);
+        const auto last = m_days.begin() + std::ptrdiff_t(bucket->end);
+        const std::size_t at = std::lower_bound(first, last, day) - m_days.begin();
+
+        std::size_t later = nextFree(at);
+        if (later >= bucket->end || m_days[later] > day + m_daysLate)
+        {
+            later = npos;
+        }
+        std::size_t earlier = prevFree(at);
+        if (earlier == npos || earlier < bucket->begin || m_days[earlier] < day - m_daysEarly)
+        {
+            earlier = npos;
+        }
+        else
+        {
+            /* the lowest index of that day rather than the highest */
+            earlier = nextFree(std::lower_bound(first, last, m_days[earlier]) - m_days.begin());
+        }
+
+        std::size_t pick = later;
+        if (earlier != npos && (later == npos || day - m_days[earlier] <= m_days[later] - day))
+        {
+            pick = earlier;
+        }
+        if (pick == npos)
+        {
+            return npos;
+        }
+        consume(pick);
+        return m_order[pick];
+    }
+
+} // namespace brlib
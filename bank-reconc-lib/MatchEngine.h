@@ -0,0 +1,105 @@
+#ifndef BRLIB_MATCHENGINE_H
+#define BRLIB_MATCHENGINE_H
+
+#include <cstdint>
+#include <limits>
+
+#include "EntryStore.h"
+#include "brlib_common.h"
+
+namespace brlib
+{
+
+    /** hash-join over books entries.
+     * the books entries given are bucketed by a (day, debit, credit) key
+     * in a flat open-addressed table; each bucket is a FIFO queue of books
+     * indices in file order, so `take()` hands out the earliest books entry that
+     * hasn't been consumed yet, i.e. the same pairing the nested loop over equal
+     * entries produced. */
+    class MatchEngine
+    {
+    public:
+        static constexpr entry_vec_sz_t npos = std::numeric_limits<entry_vec_sz_t>::max();
+
+        struct Key
+        {
+            day_t day;
+            paise_t debit, credit;
+
+            bool operator==(const Key& rhs) const = default;
+        };
+
+        /* books rows to match against, ascending */
+        MatchEngine(const EntryStore& books, const vec<entry_vec_sz_t>& booksRows);
+
+        /* pop the earliest unconsumed books index matching entries[i], or npos. */
+        entry_vec_sz_t take(const EntryStore& entries, entry_vec_sz_t i);
+
+        static Key keyOf(const EntryStore& entries, entry_vec_sz_t i);
+        static std::uint64_t hash(const Key& key);
+
+    private:
+        struct Slot
+        {
+            Key key{};
+            entry_vec_sz_t head{npos}, tail{npos};
+            bool used{false};
+        };
+
+        Slot* slotFor(const Key& key, bool insert);
+        void sizeFor(std::size_t rows);
+        void add(const EntryStore& books, entry_vec_sz_t i);
+
+        vec<Slot> m_slots;
+        vec<entry_vec_sz_t> m_next; // next books idx in the same bucket
+        std::size_t m_mask{0};
+    };
+
+    /** nearest-date matching over the books entries an exact pass left.
+     * entries are grouped by (debit, credit) and sorted by day, then index,
+     * inside each group, so the entries around a bank date are found by binary
+     * search. consumed entries are skipped through next / previous pointers
+     * that are shortened as they are followed. */
+    class DateWindowEngine
+    {
+    public:
+        static constexpr entry_vec_sz_t npos = MatchEngine::npos;
+
+        /* the books rows listed; those an exact pass left */
+        DateWindowEngine(const EntryStore& books, vec<entry_vec_sz_t> booksRows,
+                         day_t daysEarly, day_t daysLate);
+
+        /* consume the unconsumed books entry matching entries[i]'s amounts whose
+         * day is closest to it inside the window, or return npos. the earlier day
+         * wins a tie, and the lowest index among entries of that day. */
+        entry_vec_sz_t take(const EntryStore& entries, entry_vec_sz_t i);
+
+    private:
+        struct Bucket
+        {
+            paise_t debit{0}, credit{0};
+            std::size_t begin{0}, end{0};
+            bool used{false};
+        };
+
+        const Bucket* bucketFor(paise_t debit, paise_t credit) const;
+        /* first unconsumed position >= pos, or size if none */
+        std::size_t nextFree(std::size_t pos);
+        /* last unconsumed position < pos, or npos if none */
+        std::size_t prevFree(std::size_t pos);
+        void consume(std::size_t pos);
+
+        day_t m_daysEarly, m_daysLate;
+        vec<Bucket> m_buckets;
+        std::size_t m_mask{0};
+        /* books indices in bucket / day / index order, and their days */
+        vec<entry_vec_sz_t> m_order;
+        vec<day_t> m_days;
+        /* m_next[p]: p if free, else a position nearer the next free one.
+         * m_prev is the same leftwards, shifted by one so that 0 means none. */
+        vec<std::size_t> m_next, m_prev;
+    };
+
+} // namespace brlib
+
+#endif // BRLIB_MATCHENGINE_H
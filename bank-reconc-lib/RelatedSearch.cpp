@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <tuple>
+
+#include "RelatedSearch.h"
+
+namespace brlib
+{
+
+    RelatedSearch::RelatedSearch(const EntryStore& bank, const EntryStore& books,
+                                 const results_t& results,
+                                 const RelatedSearchSettings& settings):
+        m_bank(bank),
+        m_books(books), m_settings(settings),
+        m_bankByDay(sortedByDay(bank, results.missingInBook, results.bankMissing)),
+        m_booksByDay(sortedByDay(books, results.missingInBank, results.booksMissing))
+    {
+        m_settings.maxCandidates = std::min(m_settings.maxCandidates, 64u);
+    }
+
+    vec<RelatedSearch::Dated> RelatedSearch::sortedByDay(const EntryStore& store,
+                                                         const vec<entry_vec_sz_t>& unmatched,
+                                                         const vec<bool>& missing)
+    {
+        vec<Dated> dated;
+        dated.reserve(unmatched.size());
+        for (const entry_vec_sz_t i : unmatched)
+        {
+            if (isMissing(missing, i))
+            {
+                dated.push_back({store.day(i), i});
+            }
+        }
+        std::sort(dated.begin(), dated.end(), [](const Dated& lhs, const Dated& rhs) {
+            return std::tie(lhs.day, lhs.idx) < std::tie(rhs.day, rhs.idx);
+        });
+        return dated;
+    }
+
+    vec<RelatedSearch::Candidate>
+      RelatedSearch::candidatesFor(EntryPointer::For parentFor, entry_vec_sz_t parent) const
+    {
+        const bool fromBank = parentFor == EntryPointer::For::Bank;
+        const EntryStore& parents = fromBank ? m_bank : m_books;
+        const EntryStore& children = fromBank ? m_books : m_bank;
+        const vec<Dated>& byDay = fromBank ? m_booksByDay : m_bankByDay;
+
+        const day_t day = parents.day(parent);
+        const paise_t target = parents.amount(parent);
+        const bool isDebit = parents.debit(parent) != 0;
+
+        auto it = std::lower_bound(
+          byDay.begin(), byDay.end(), day - m_settings.daysBefore,
+          [](const Dated& d, day_t first) { return d.day < first; });
+        vec<Candidate> cands;
+        for (; it != byDay.end() && it->day <= day + m_settings.daysAfter; ++it)
+        {
+            const paise_t amt = children.amount(it->idx);
+            if ((children.debit(it->idx) != 0) == isDebit && amt > 0 && amt < target)
+            {
+                cands.push_back({it->idx, amt, std::abs(long(it->day) - day)});
+            }
+        }
+
+        if (cands.size() > m_settings.maxCandidates)
+        {
+            auto nearer = [](const Candidate& lhs, const Candidate& rhs) {
+                return std::tie(lhs.dateCost, lhs.idx) < std::tie(rhs.dateCost, rhs.idx);
+            };
+            std::nth_element(cands.begin(), cands.begin() + m_settings.maxCandidates,
+                             cands.end(), nearer);
+            cands.resize(m_settings.maxCandidates);
+        }
+        /* a fixed order, largest first with ties by index, so the two halves and
+         * the bit masks, and with them the tie-break between equal groups, don't
+         * depend on where nth_element left the candidates */
+        std::sort(cands.begin(), cands.end(), [](const Candidate& lhs, const Candidate& rhs) {
+            return lhs.amount != rhs.amount ? lhs.amount > rhs.amount : lhs.idx < rhs.idx;
+        });
+        return cands;
+    }
+
+    /* every subset of cands[first, last) of at most maxGroupSize entries summing
+     * to at most target. false once the step budget is spent. */
+    bool RelatedSearch::enumerate(const vec<Candidate>& cands, std::size_t first,
+                                  std::size_t last, paise_t target, vec<Subset>& out,
+                                  std::size_t& steps) const
+    {
+        auto walk = [&](auto& self, std::size_t pos, const Subset& cur) -> bool {
+            out.push_back(cur);
+            if (++steps > m_settings.stepBudget)
+            {
+                return false;
+            }
+            if (cur.size == m_settings.maxGroupSize)
+            {
+                return true;
+            }
+            for (std::size_t i = pos; i < last; ++i)
+            {
+                if (cur.sum + cands[i].amount > target)
+                {
+                    continue;
+                }
+                const Subset next{cur.sum + cands[i].amount, cur.dateCost + cands[i].dateCost,
+                                  cur.mask | (std::uint64_t(1) << i), cur.size + 1};
+                if (!self(self, i + 1, next))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        return walk(walk, first, Subset{0, 0, 0, 0});
+    }
+
+    std::optional<RelatedSearch::Group> RelatedSearch::search(EntryPointer::For parentFor,
+                                                              entry_vec_sz_t parent) const
+    {
+        const EntryStore& parents = parentFor == EntryPointer::For::Bank ? m_bank : m_books;
+        const paise_t target = parents.amount(parent);
+        const vec<Candidate> cands = candidatesFor(parentFor, parent);
+        if (cands.size() < 2 || m_settings.maxGroupSize < 2)
+        {
+            return std::nullopt;
+        }
+        paise_t total = 0;
+        for (const Candidate& c : cands)
+        {
+            total += c.amount;
+        }
+        if (total < target)
+        {
+            return std::nullopt;
+        }
+
+        const std::size_t half = cands.size() / 2;
+        std::size_t steps = 0;
+        vec<Subset> left, right;
+        if (!enumerate(cands, 0, half, target, left, steps) ||
+            !enumerate(cands, half, cands.size(), target, right, steps))
+        {
+            return std::nullopt;
+        }
+        std::sort(right.begin(), right.end(), [](const Subset& lhs, const Subset& rhs) {
+            return std::tie(lhs.sum, lhs.size, lhs.dateCost, lhs.mask) <
+                   std::tie(rhs.sum, rhs.size, rhs.dateCost, rhs.mask);
+        });
+
+        /* right subsets of one sum are ordered by size, date cost and mask, so the
+         * first one big enough is the best partner of a left subset. */
+        std::optional<Subset> best;
+        for (const Subset& l : left)
+        {
+            if (++steps > m_settings.stepBudget)
+            {
+                return std::nullopt;
+            }
+            const paise_t need = target - l.sum;
+            auto it = std::lower_bound(right.begin(), right.end(), need,
+                                       [](const Subset& s, paise_t sum) { return s.sum < sum; });
+            const unsigned minSize = l.size >= 2 ? 0 : 2 - l.size;
+            while (it != right.end() && it->sum == need && it->size < minSize)
+            {
+                ++it;
+            }
+            if (it == right.end() || it->sum != need ||
+                l.size + it->size > m_settings.maxGroupSize)
+            {
+                continue;
+            }
+            const Subset both{target, l.dateCost + it->dateCost, l.mask | it->mask,
+                              l.size + it->size};
+            if (!best || std::tie(both.size, both.dateCost, both.mask) <
+                           std::tie(best->size, best->dateCost, best->mask))
+            {
+                best = both;
+            }
+        }
+        if (!best)
+        {
+            return std::nullopt;
+        }
+
+        Group group{parentFor, parent, {}, best->dateCost};
+        for (std::size_t i = 0; i < cands.size(); ++i)
+        {
+            if (best->mask & (std::uint64_t(1) << i))
+            {
+                group.children.push_back(cands[i].idx);
+            }
+        }
+        std::sort(group.children.begin(), group.children.end());
+        return group;
+    }
+
+    bool RelatedSearch::betterThan(const Group& lhs, const Group& rhs)
+    {
+        return std::make_tuple(lhs.children.size(), lhs.dateCost, lhs.parentFor, lhs.parent,
+                               std::cref(lhs.children)) <
+               std::make_tuple(rhs.children.size(), rhs.dateCost, rhs.parentFor, rhs.parent,
+                               std::cref(rhs.children));
+    }
+
+    vec<RelatedSearch::Group> RelatedSearch::resolve(vec<Group> groups) const
+    {
+        std::sort(groups.begin(), groups.end(), betterThan);
+        vec<bool> bankUsed(m_bank.size(), false), booksUsed(m_books.size(), false);
+        vec<Group> kept;
+        for (Group& g : groups)
+        {
+            const bool fromBank = g.parentFor == EntryPointer::For::Bank;
+            vec<bool>& parentUsed = fromBank ? bankUsed : booksUsed;
+            vec<bool>& childUsed = fromBank ? booksUsed : bankUsed;
+            if (parentUsed[g.parent] ||
+                std::any_of(g.children.begin(), g.children.end(),
+                            [&](entry_vec_sz_t c) { return bool(childUsed[c]); }))
+            {
+                continue;
+            }
+            parentUsed[g.parent] = true;
+            for (const entry_vec_sz_t c : g.children)
+            {
+                childUsed[c] = true;
+            }
+            kept.push_back(std::move(g));
+        }
+        return kept;
+    }
+
+} // namespace brlib
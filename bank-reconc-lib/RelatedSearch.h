@@ -0,0 +1,98 @@
+#ifndef BRLIB_RELATEDSEARCH_H
+#define BRLIB_RELATEDSEARCH_H
+
+#include <cstdint>
+#include <optional>
+
+#include "EntryMatch.h"
+#include "EntryStore.h"
+#include "brlib_common.h"
+
+namespace brlib
+{
+
+    /** exact one-to-many groups among unmatched entries.
+     * a parent is an entry missing on the other side; its children are two or
+     * more unmatched entries of the other side, in the same debit / credit
+     * column and inside the date window, whose amounts add up to the parent's
+     * to the paisa. the nearest candidates are split in two halves whose subset
+     * sums are met in the middle, so a search costs about 2 * 2^(n/2) steps
+     * instead of 2^n. */
+    class RelatedSearch
+    {
+    public:
+        struct Group
+        {
+            EntryPointer::For parentFor;
+            entry_vec_sz_t parent;
+            /* other side's indices, ascending */
+            vec<entry_vec_sz_t> children;
+            /* days between each child and the parent, summed */
+            long dateCost;
+        };
+
+        RelatedSearch(const EntryStore& bank, const EntryStore& books,
+                      const results_t& results, const RelatedSearchSettings& settings);
+
+        /* the best exact group for the parent, or nothing if there is none or the
+         * step budget ran out. doesn't modify the search, so parents can be
+         * searched from several threads. */
+        [[nodiscard]] std::optional<Group> search(EntryPointer::For parentFor,
+                                                  entry_vec_sz_t parent) const;
+
+        /* fewer children first, then closer dates, then bank parents and lower
+         * indices, so the order never depends on how the groups were found. */
+        static bool betterThan(const Group& lhs, const Group& rhs);
+
+        /* keep the best groups that share no entry with a better one */
+        [[nodiscard]] vec<Group> resolve(vec<Group> groups) const;
+
+        /* whether a missing list's entry i is still missing; results built
+         * without the missing bits count every listed entry as missing */
+        static bool isMissing(const vec<bool>& bits, entry_vec_sz_t i)
+        {
+            return bits.empty() || (i < bits.size() && bits[i]);
+        }
+
+    private:
+        struct Candidate
+        {
+            entry_vec_sz_t idx;
+            paise_t amount;
+            long dateCost;
+        };
+
+        /* a subset of one half: bits of the candidates in it */
+        struct Subset
+        {
+            paise_t sum;
+            long dateCost;
+            std::uint64_t mask;
+            unsigned size;
+        };
+
+        struct Dated
+        {
+            day_t day;
+            entry_vec_sz_t idx;
+        };
+
+        [[nodiscard]] vec<Candidate> candidatesFor(EntryPointer::For parentFor,
+                                                   entry_vec_sz_t parent) const;
+        bool enumerate(const vec<Candidate>& cands, std::size_t first, std::size_t last,
+                       paise_t target, vec<Subset>& out, std::size_t& steps) const;
+
+        static vec<Dated> sortedByDay(const EntryStore& store,
+                                      const vec<entry_vec_sz_t>& unmatched,
+                                      const vec<bool>& missing);
+
+        const EntryStore& m_bank;
+        const EntryStore& m_books;
+        RelatedSearchSettings m_settings;
+        /* unmatched entries of each side by date, as children of the other */
+        vec<Dated> m_bankByDay, m_booksByDay;
+    };
+
+} // namespace brlib
+
+#endif // BRLIB_RELATEDSEARCH_H
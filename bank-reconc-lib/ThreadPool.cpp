@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "ThreadPool.h"
+
+namespace brlib
+{
+
+    ThreadPool::ThreadPool(unsigned threads)
+    {
+        if (!threads)
+        {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_workers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            m_workers.emplace_back(&ThreadPool::run, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (std::thread& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool& ThreadPool::shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    namespace
+    {
+        /* the part of a parallelFor range one thread still has to do */
+        struct Slice
+        {
+            std::mutex mutex;
+            std::size_t begin{0}, end{0};
+        };
+    } // namespace
+
+    void ThreadPool::parallelFor(std::size_t count, unsigned threads,
+                                 const std::function<void(std::size_t)>& fn)
+    {
+        if (!threads)
+        {
+            threads = size();
+        }
+        threads = unsigned(std::clamp<std::size_t>(count, 1, threads));
+        if (threads == 1)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                fn(i);
+            }
+            return;
+        }
+
+        const std::unique_ptr<Slice[]> slices(new Slice[threads]);
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            slices[t].begin = count * t / threads;
+            slices[t].end = count * (t + 1) / threads;
+        }
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        auto next = [&](unsigned self, std::size_t& i) {
+            Slice& own = slices[self];
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.begin != own.end)
+                {
+                    i = own.begin++;
+                    return true;
+                }
+            }
+            /* steal the back half of the biggest slice. it may have shrunk
+             * between the scan and the split, which is rechecked under its lock */
+            for (;;)
+            {
+                unsigned victim = self;
+                std::size_t most = 0;
+                for (unsigned t = 0; t < threads; ++t)
+                {
+                    std::lock_guard<std::mutex> lock(slices[t].mutex);
+                    if (slices[t].end - slices[t].begin > most)
+                    {
+                        most = slices[t].end - slices[t].begin;
+                        victim = t;
+                    }
+                }
+                if (!most)
+                {
+                    return false;
+                }
+                std::size_t first, last;
+                {
+                    std::lock_guard<std::mutex> lock(slices[victim].mutex);
+                    Slice& v = slices[victim];
+                    if (v.begin == v.end)
+                    {
+                        continue;
+                    }
+                    first = v.end - (v.end - v.begin + 1) / 2;
+                    last = v.end;
+                    v.end = first;
+                }
+                std::lock_guard<std::mutex> lock(own.mutex);
+                i = first;
+                own.begin = first + 1;
+                own.end = last;
+                return true;
+            }
+        };
+        auto work = [&](unsigned self) {
+            std::size_t i = 0;
+            while (!failed.load(std::memory_order_relaxed) && next(self, i))
+            {
+                try
+                {
+                    fn(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        };
+
+        vec<std::future<void>> helpers;
+        helpers.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; ++t)
+        {
+            helpers.push_back(submit([&work, t]() { work(t); }));
+        }
+        work(0);
+        for (std::future<void>& f : helpers)
+        {
+            f.wait();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void ThreadPool::run()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+                /* drain what's queued before stopping */
+                if (m_tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+} // namespace brlib
@@ -0,0 +1,71 @@
+#ifndef BRLIB_THREADPOOL_H
+#define BRLIB_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "brlib_common.h"
+
+namespace brlib
+{
+
+    /** fixed set of worker threads draining one FIFO of tasks. tasks shouldn't
+     * block on other tasks of the same pool; callers wait on the futures. */
+    class ThreadPool
+    {
+    public:
+        /* 0 threads means one per hardware thread */
+        explicit ThreadPool(unsigned threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template<typename F>
+        auto submit(F&& task) -> std::future<std::invoke_result_t<F>>
+        {
+            using result_t = std::invoke_result_t<F>;
+            auto packaged =
+              std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(task));
+            std::future<result_t> result = packaged->get_future();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.emplace_back([packaged]() { (*packaged)(); });
+            }
+            m_cv.notify_one();
+            return result;
+        }
+
+        /** calls fn(i) for each i in [0, count) on up to `threads` threads, the
+         * caller being one of them; 0 threads means as many as the pool has
+         * workers. each thread works from the front of its own slice of the
+         * range, and one that runs dry steals the back half of the largest
+         * slice left, so uneven calls still keep every thread busy. returns
+         * when all calls have; the first exception thrown is rethrown here and
+         * stops handing out indices. not for use from a task of this pool. */
+        void parallelFor(std::size_t count, unsigned threads,
+                         const std::function<void(std::size_t)>& fn);
+
+        [[nodiscard]] unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+        /* process-wide pool, started on first use */
+        static ThreadPool& shared();
+
+    private:
+        void run();
+
+        vec<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_stop{false};
+    };
+
+} // namespace brlib
+
+#endif // BRLIB_THREADPOOL_H
@@ -1,16 +1,101 @@
+#include <charconv>
+#include <cstring>
+
 #include "brlib_common.h"
 
 namespace brlib
 {
 
-    bool dt_equal(const std::tm& lhs, const std::tm& rhs)
+    /* civil calendar <-> day number, after H. Hinnant's days_from_civil. */
+    day_t daysFromCivil(int year, unsigned month, unsigned mday)
+    {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(year - era * 400);
+        const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + mday - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<day_t>(doe) - 719468;
+    }
+
+    std::tm tmFromDays(day_t day)
+    {
+        day += 719468;
+        const int era = (day >= 0 ? day : day - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(day - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        const unsigned mday = doy - (153 * mp + 2) / 5 + 1;
+        const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+        const int year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+
+        std::tm t{};
+        t.tm_year = year - 1900;
+        t.tm_mon = static_cast<int>(month) - 1;
+        t.tm_mday = static_cast<int>(mday);
+        t.tm_isdst = -1;
+        return t;
+    }
+
+    char* formatMoney(paise_t paise, char* out)
+    {
+        /* built backwards from the last digit, then copied forwards */
+        char buf[displayChars];
+        char* p = buf + sizeof buf;
+        std::uint64_t v = paise < 0 ? 0u - static_cast<std::uint64_t>(paise)
+                                    : static_cast<std::uint64_t>(paise);
+        *--p = char('0' + v % 10);
+        v /= 10;
+        *--p = char('0' + v % 10);
+        v /= 10;
+        *--p = '.';
+        /* a group of 3 above the paise, then groups of 2 */
+        unsigned group = 3, inGroup = 0;
+        do
+        {
+            if (inGroup == group)
+            {
+                *--p = ',';
+                inGroup = 0;
+                group = 2;
+            }
+            *--p = char('0' + v % 10);
+            v /= 10;
+            ++inGroup;
+        } while (v);
+        if (paise < 0)
+        {
+            *--p = '-';
+        }
+        const std::size_t n = static_cast<std::size_t>(buf + sizeof buf - p);
+        std::memcpy(out, p, n);
+        return out + n;
+    }
+
+    char* formatDay(day_t day, char* out)
     {
-        return (lhs.tm_mday == rhs.tm_mday) && (lhs.tm_mon == rhs.tm_mon) &&
-               (lhs.tm_year == rhs.tm_year);
+        const std::tm t = tmFromDays(day);
+        auto two = [&out](unsigned v) {
+            *out++ = char('0' + v / 10 % 10);
+            *out++ = char('0' + v % 10);
+        };
+        two(static_cast<unsigned>(t.tm_mday));
+        *out++ = '-';
+        two(static_cast<unsigned>(t.tm_mon + 1));
+        *out++ = '-';
+        const int year = t.tm_year + 1900;
+        if (year < 1000 || year > 9999)
+        {
+            return std::to_chars(out, out + 12, year).ptr;
+        }
+        two(static_cast<unsigned>(year / 100));
+        two(static_cast<unsigned>(year % 100));
+        return out;
     }
 
     void ParseSettings::setAutoParse(bool value)
     {
+        m_autoParse = value;
         bank.autoParse = value;
         books.autoParse = value;
     }
@@ -1,12 +1,15 @@
 #ifndef BRLIB_COMMON_H
 #define BRLIB_COMMON_H
 
+#include <atomic>
+#include <cstdint>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -26,33 +29,55 @@ namespace brlib
     /* fwd decl */
     class EntryBase;
     class EntryMatch;
+    class EntryStore;
 
-    using entry_vec = vec<EntryBase>;
-    using entry_vec_sz_t = vec<EntryBase>::size_type;
+    using entry_vec_sz_t = std::size_t;
 
     struct results_t
     {
         vec<EntryMatch> matches;
         vec<entry_vec_sz_t> missingInBook;
         vec<entry_vec_sz_t> missingInBank;
+
+        /* one bit per passed entry, set once that entry is part of a match. */
+        vec<bool> bankMatched;
+        vec<bool> booksMatched;
+
+        /* one bit per passed entry, set while it's missing on the other side:
+         * bank entries of missingInBook, books entries of missingInBank.
+         * manual matching goes by these bits; after saveManualMatch the lists
+         * may still hold entries it cleared, until syncMissing. */
+        vec<bool> bankMissing;
+        vec<bool> booksMissing;
+        bool missingStale{false};
     };
 
     using pr_vec_t = std::pair<entry_vec_sz_t, entry_vec_sz_t>;
 
-    bool dt_equal(const std::tm& lhs, const std::tm& rhs);
+    /* days since 1970-01-01 */
+    using day_t = std::int32_t;
+
+    /* money in paise; 64 bits wherever long is 32 */
+    using paise_t = std::int64_t;
+
+    day_t daysFromCivil(int year, unsigned month, unsigned mday);
+    std::tm tmFromDays(day_t day);
 
     struct DateFormat
     {
         str value;
         str label;
+        /* layout used by parse::parseDate: dd<sep>mm<sep>yy or yyyy */
+        char sep;
+        unsigned short yearDigits;
     };
 
-    /* things are messy with parsing dates. dd-mm-yy is parsed to 20th century. */
+    /* 2 digit years are read as 20yy on every platform. */
     static const DateFormat dateFormats[] = {
-      {"%d-%m-%y", "dd-mm-yy"},
-      {"%d/%m/%y", "dd/mm/yy"},
-      {"%d-%m-%Y", "dd-mm-yyyy"},
-      {"%d/%m/%Y", "dd/mm/yyyy"},
+      {"%d-%m-%y", "dd-mm-yy", '-', 2},
+      {"%d/%m/%y", "dd/mm/yy", '/', 2},
+      {"%d-%m-%Y", "dd-mm-yyyy", '-', 4},
+      {"%d/%m/%Y", "dd/mm/yyyy", '/', 4},
     };
 
     struct Delim
@@ -118,10 +143,76 @@ namespace brlib
           {Date, 0}, {Narr, 1}, {Debit, 2}, {Credit, 3}, {Balance, 4}, {Amount, -1}, {TransactionType, -1}};
     };
 
+    struct ReconcileSettings
+    {
+        /* re-run the reference nested loop over the same input and throw if its
+         * results_t differs from the hash-join's. slow; meant for regressions. */
+        bool crossCheck{false};
+        /* books entries dated up to this many days before / after a bank entry
+         * still match it, once every same-date match has been made. the
+         * closest date wins, the earlier one on a tie. 0, 0 is exact dates. */
+        day_t booksDaysEarly{0}, booksDaysLate{0};
+    };
+
+    /* limits of the one-to-many search in findRelatedRecords */
+    struct RelatedSearchSettings
+    {
+        /* entries summed into a parent may be dated this many days around it */
+        day_t daysBefore{5}, daysAfter{5};
+        /* most entries summed into one parent */
+        unsigned maxGroupSize{5};
+        /* only the entries nearest the parent's date are tried; at most 64 */
+        unsigned maxCandidates{24};
+        /* subsets tried per parent before giving up on it. a step count rather
+         * than a clock, so a busy machine proposes the same groups. */
+        std::size_t stepBudget{1 << 16};
+        /* 0: one per hardware thread; 1: search on the calling thread */
+        unsigned threads{0};
+    };
+
+    class Cancelled : public std::runtime_error
+    {
+    public:
+        Cancelled():
+            std::runtime_error("cancelled") {}
+    };
+
+    /** shared with a thread running a long parse or reconciliation, to follow
+     * and stop it. the work adds to the counters every few thousand rows and,
+     * once cancel is set, throws Cancelled at its next check. */
+    struct Progress
+    {
+        /* input bytes parsed, headers and rows already held included */
+        std::atomic<std::size_t> bytesParsed{0};
+        /* bank rows that have been through matching */
+        std::atomic<std::size_t> rowsMatched{0};
+        std::atomic<bool> cancel{false};
+
+        /* rows between counter updates and cancel checks */
+        static constexpr std::size_t stride = 4096;
+
+        void check() const
+        {
+            if (cancel.load(std::memory_order_relaxed))
+            {
+                throw Cancelled();
+            }
+        }
+    };
+
+    struct ParallelParseSettings
+    {
+        /* 0: one per hardware thread; 1: parse on the calling thread */
+        unsigned threads{0};
+        /* files are only split into chunks of at least this many bytes */
+        std::size_t minChunkBytes{1 << 20};
+    };
+
     class ParseSettings
     {
     public:
         ManualParseSettings bank, books;
+        ParallelParseSettings parallel;
 
         void setAutoParse(bool value);
         [[nodiscard]] bool isAutoParseEnabled() const;
@@ -143,6 +234,17 @@ namespace brlib
         string_type do_grouping() const override { return "\003\002"; }
     };
 
+    /* room formatMoney and formatDay need at out */
+    inline constexpr std::size_t displayChars = 32;
+
+    /* paise grouped as indianMoneyPunct groups them, 1,23,456.78, with a
+     * leading 0 and a minus sign that put_money leaves out. written at out
+     * without iostreams; returns one past the last char. */
+    char* formatMoney(paise_t paise, char* out);
+
+    /* day as printDay writes it, dd-mm-yyyy; returns one past the last char */
+    char* formatDay(day_t day, char* out);
+
 } // namespace brlib
 
 #endif // BRLIB_COMMON_H
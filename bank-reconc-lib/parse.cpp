@@ -1,75 +1,89 @@
 #include <algorithm>
+#include <limits>
 #include <map>
+#include <optional>
 #include <sstream>
 
 #include "EntryBase.h"
+#include "EntryStore.h"
+#include "FieldScanner.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
 #include "parse.h"
 
 namespace brlib::parse
 {
 
-    long checkZero(str& s) { return s.empty() ? 0 : toPaise(s); }
+    paise_t checkZero(std::string_view s) { return s.empty() ? 0 : toPaise(s); }
 
     str::size_type wasFound(str::size_type pos) { return pos != str::npos; }
 
-    unsigned getDelimsBefore(str& s, str::size_type pos, const char delimChar)
+    std::string_view nextLine(std::string_view& rest)
     {
-        unsigned cnt = 0;
-        while (pos != str::npos && pos != 0)
+        const auto nl = rest.find('\n');
+        std::string_view line = rest.substr(0, nl);
+        rest.remove_prefix(nl == std::string_view::npos ? rest.size() : nl + 1);
+        if (!line.empty() && line.back() == '\r')
         {
-            if (s.at(pos) == '"')
-            {
-                pos = s.rfind('"', pos - 1);
-            }
-            else
-            {
-                if (isprint(s.at(pos)))
-                {
-                    pos = s.rfind(delimChar, pos);
-                    if (pos == str::npos)
-                    {
-                        break;
-                    }
-                    else
-                    {
-                        ++cnt;
-                    }
-                }
-            }
-            --pos;
+            line.remove_suffix(1);
         }
-        return cnt;
+        return line;
+    }
+
+    void RowFields::split(std::string_view row, char delimChar)
+    {
+        m_row = row;
+        m_delim = delimChar;
+        m_delims.clear();
+        scanDelims(row, delimChar, m_delims);
     }
 
-    str::size_type getDelimPos(str& s, unsigned cnt, const char& delimChar)
+    std::size_t RowFields::fieldAt(std::size_t pos) const
     {
-        str::size_type pos = 0;
-        unsigned _cnt = 0;
-        while (pos < s.size() && cnt > 0)
+        return std::lower_bound(m_delims.begin(), m_delims.end(), pos) - m_delims.begin();
+    }
+
+    std::string_view RowFields::operator[](std::size_t i) const
+    {
+        if (i > m_delims.size())
         {
-            if (s.at(pos) == '"')
-            {
-                pos = s.find('"', pos + 1);
-            }
-            if (s.at(pos) == delimChar)
-            {
-                ++_cnt;
-                if (_cnt == cnt)
-                {
-                    return pos;
-                }
-            }
-            pos++;
+            return {};
+        }
+        const std::size_t begin = i ? m_delims[i - 1] + 1 : 0;
+        const std::size_t end = i < m_delims.size() ? m_delims[i] : m_row.size();
+        return unquote(m_row.substr(begin, end - begin), m_delim);
+    }
+
+    std::string_view RowFields::trimmed(std::size_t i) const
+    {
+        if (i > m_delims.size())
+        {
+            return {};
         }
-        return pos;
+        const std::size_t begin = i ? m_delims[i - 1] + 1 : 0;
+        const std::size_t end = i < m_delims.size() ? m_delims[i] : m_row.size();
+        std::string_view col = m_row.substr(begin, end - begin);
+        col.remove_prefix(std::min(col.find_first_not_of(" \t\r\v\f"), col.size()));
+        col = unquote(col, m_delim);
+        rtrim(col);
+        return col;
     }
 
-    /** given the filestream, find the header row, look for special delim chars,
+    std::string_view unquote(std::string_view s, char delimChar)
+    {
+        if (!s.empty() && s.front() == '"')
+        {
+            s.remove_prefix(1);
+            return s.substr(0, s.find('"'));
+        }
+        return s.substr(0, s.find(delimChar));
+    }
+
+    /** given the file contents, find the header row, look for special delim chars,
  * get the number of delim chars before each column name, save it to options,
  * so we know how many chars to skip while parsing value for each column name
- * while parsing each data row. look at 10 rows only, then seek the stream to 0
- * and leave it there. */
-    void configureAutoParse(std::fstream& filestrm, AutoParseSettings& options)
+ * while parsing each data row. look at 50 rows at most. */
+    void configureAutoParse(std::string_view data, AutoParseSettings& options)
     {
 
         int cnt = 0;
@@ -83,9 +97,10 @@ namespace brlib::parse
 
         using str_sz = str::size_type;
 
-        str line;
-        while (getline(filestrm, line) && cnt < 51 && !dateFormatRetrieved)
+        std::string_view rest = data;
+        while (!rest.empty() && cnt < 51 && !dateFormatRetrieved)
         {
+            const std::string_view line = nextLine(rest);
 
             /** header logic here:
      * - find header row, so we can skip all rows till that position for data.
@@ -137,19 +152,23 @@ namespace brlib::parse
                         delim = '\t';
                         specialDelim = true;
                     }
-                    options.headerDelimsCount =
-                      getDelimsBefore(line, line.size() - 1, delim);
+                    const RowFields header(line, delim);
+                    /* delims before pos in the header; 0 if the word wasn't found */
+                    auto delimsBeforePos = [&](str_sz pos) -> long {
+                        return wasFound(pos) ? long(header.fieldAt(pos)) : 0;
+                    };
+                    options.headerDelimsCount = header.delimCount();
                     options.headerAt = cnt;
-                    delimsBefore.date = getDelimsBefore(line, datePos, delim);
+                    delimsBefore.date = delimsBeforePos(datePos);
                     if (wasFound(debitPos) && wasFound(creditPos))
                     {
-                        delimsBefore.debit = getDelimsBefore(line, debitPos, delim);
-                        delimsBefore.credit = getDelimsBefore(line, creditPos, delim);
+                        delimsBefore.debit = delimsBeforePos(debitPos);
+                        delimsBefore.credit = delimsBeforePos(creditPos);
                     }
                     else
                     {
                         options.singleAmountCol = true;
-                        delimsBefore.amount = getDelimsBefore(line, amountPos, delim);
+                        delimsBefore.amount = delimsBeforePos(amountPos);
 
                         static const str trxTypeSearchWords[] = {"Cr/Dr", "Dr/Cr",
                                                                  "Transaction Type"};
@@ -166,7 +185,7 @@ namespace brlib::parse
                         }
                         else
                         {
-                            delimsBefore.transType = getDelimsBefore(line, trxTypePos, delim);
+                            delimsBefore.transType = delimsBeforePos(trxTypePos);
                         }
                     }
                     static const str narrSearchWords[] = {"Narr", "Particulars", "Account",
@@ -181,70 +200,34 @@ namespace brlib::parse
                     {
                         throw InvalidHeaderError("narration not found.");
                     }
-                    delimsBefore.narr = getDelimsBefore(line, narrPos, delim);
-                    delimsBefore.balance = getDelimsBefore(line, balancePos, delim);
+                    delimsBefore.narr = delimsBeforePos(narrPos);
+                    delimsBefore.balance = delimsBeforePos(balancePos);
                 }
             }
 
-            /** for parsing date format, we try to construct a valid std::tm object by
-     * iterating over formats in dateFormats.*/
+            /** for parsing date format, we try to decode a valid date by iterating
+     * over formats in dateFormats.*/
             bool extractFromLine =
               options.headerAt != -1 && cnt > options.headerAt && !line.empty();
-            auto dtPos = getDelimPos(line, delimsBefore.date, delim);
-            if (extractFromLine && (line.find(delim) != str::npos) && wasFound(dtPos) &&
-                !dateFormatRetrieved)
-            {
-                std::istringstream iss;
-                if (dtPos)
-                { // bad hack; normally we'd want to substr from delimPos + 1
-                    iss.str(line.substr(dtPos + 1));
-                }
-                else
-                { // but if date is first char, we can't add 1;
-                    iss.str(line.substr(dtPos));
-                }
-                str dirty, cleaned;
-                getline(iss, dirty, delim);
-                iss.clear();
-                iss.str(dirty);
-                iss >> std::quoted(cleaned);
-                iss.str(cleaned);
-                std::tm t{};
-                iss.clear();
-                iss.str(cleaned);
-                /** get_time() sets a badbit in stream if parsing fails.
-       * we test the fail status of istringstream to stay in loop.
-       * Set the badbit initially to enter loop. */
-                iss.setstate(std::ios::badbit);
+            if (extractFromLine && (line.find(delim) != str::npos) && !dateFormatRetrieved)
+            {
+                /** the first format that decodes the date fixes it for the
+       * file; years are fixed width, so dd-mm-yy can't pass for
+       * dd-mm-yyyy. */
+                const std::string_view cleaned = RowFields(line, delim)[delimsBefore.date];
+                day_t day;
                 for (auto& fmt : dateFormats)
                 {
-                    /** the fist condition in below if is to bypass a bug(?) of get_time.
-         * 01-01-20 was being assigned the format dd-mm-yyyy. Since the size of
-         * label for %d-%m-%y [i.e. dd-mm-yy] will match the size of date string
-         * to parse, we can ensure we have the correct date format. */
-                    if (fmt.label.size() == cleaned.size() &&
-                        (iss.fail() || t.tm_year == 0))
+                    if (parseDate(cleaned, fmt, day))
                     {
-                        /* reset the stream once inside loop */
-                        iss.clear();
-                        iss.str(cleaned);
-                        const str format(fmt.value);
-                        iss >> std::get_time(&t, format.data());
-                        if (!iss.fail())
-                        {
-                            /** if stream makes through to here, we've got our format. */
-                            options.dateFormat = fmt;
-                            dateFormatRetrieved = true;
-                            break;
-                        }
+                        options.dateFormat = fmt;
+                        dateFormatRetrieved = true;
+                        break;
                     }
                 }
             }
             ++cnt;
         }
-        /** clear and reset the stream, so data parsing can begin from beginning. */
-        filestrm.clear();
-        filestrm.seekg(0, std::ios::beg);
         if (options.headerAt == -1)
         {
             throw InvalidHeaderError(
@@ -267,159 +250,359 @@ namespace brlib::parse
         return s;
     }
 
-    vec<str> parseDelimitedRecord(const str& s, char delimChar)
+    vec<std::string_view> parseDelimitedRecord(std::string_view s, char delimChar)
     {
-        istringstream ss(s);
-        vec<str> cols;
-        while (ss.good())
-        {
-            str substr;
-            getline(ss >> std::ws, substr, delimChar);
-            std::istringstream iss{substr};
-            str x;
-            iss >> std::quoted(x);
-            std::string_view sv(x);
-            rtrim(sv);
-            cols.push_back(str(sv));
+        const RowFields fields(s, delimChar);
+        vec<std::string_view> cols;
+        cols.reserve(fields.size());
+        for (std::size_t i = 0; i < fields.size(); ++i)
+        {
+            cols.push_back(fields.trimmed(i));
         }
         return cols;
     }
-    std::tm parseDate(istringstream& iss, const str& fmt)
-    {
-        std::tm _tm{};
-        iss >> std::get_time(&_tm, fmt.data());
-        return _tm;
-    }
 
-    long toPaise(const str& s)
+    namespace
     {
-        std::istringstream ss(s);
-
-        /** it's crucial for cout to be using the locale with the custom moneypunct,
-   * so get_money can function predictably */
-        ss.imbue(std::cout.getloc());
-        long double d;
-        ss >> std::get_money(d);
-        return long(d);
-    }
+        /* read n ascii digits at pos into out; false on anything else */
+        inline bool readDigits(std::string_view s, std::size_t pos, std::size_t n,
+                               unsigned& out)
+        {
+            out = 0;
+            for (std::size_t i = pos; i != pos + n; ++i)
+            {
+                const unsigned d = static_cast<unsigned char>(s[i]) - unsigned('0');
+                if (d > 9)
+                {
+                    return false;
+                }
+                out = out * 10 + d;
+            }
+            return true;
+        }
 
-    /** balance may have a Cr or Dr suffix in case of books data. */
-    long getBalance(str& str1)
-    {
-        auto pos = str1.find("Cr");
-        if (pos <= str1.size())
+        inline bool isLeapYear(unsigned y)
         {
-            str1.erase(pos, str1.size() - 1);
-            return checkZero(str1) * -1; // cr balance in books == -ve
+            return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
         }
-        else if (str1.find("Dr") < str1.size())
+
+        /* a day or month of 1 or 2 digits at pos, ended by Sep; pos moves past Sep */
+        template<char Sep>
+        inline bool readField(std::string_view s, std::size_t& pos, unsigned& out)
         {
-            pos = str1.find("Dr");
-            str1.erase(pos, str1.size() - 1);
-            return checkZero(str1);
+            const std::size_t end = s.find(Sep, pos);
+            if (end == std::string_view::npos || end == pos || end - pos > 2 ||
+                !readDigits(s, pos, end - pos, out))
+            {
+                return false;
+            }
+            pos = end + 1;
+            return true;
         }
-        else
+
+        /** d<Sep>m<Sep>yy or d<Sep>m<Sep>yyyy, day and month of 1 or 2 digits as
+         * get_time took them; one instance per layout in dateFormats. */
+        template<char Sep, unsigned YearDigits>
+        bool decodeDate(std::string_view s, day_t& day)
         {
-            return checkZero(str1);
+            static constexpr unsigned char monthDays[] = {31, 28, 31, 30, 31, 30,
+                                                          31, 31, 30, 31, 30, 31};
+            std::size_t pos = 0;
+            unsigned d, m, y;
+            if (!readField<Sep>(s, pos, d) || !readField<Sep>(s, pos, m) ||
+                s.size() - pos != YearDigits || !readDigits(s, pos, YearDigits, y))
+            {
+                return false;
+            }
+            if (YearDigits == 2)
+            {
+                y += 2000;
+            }
+            if (m < 1 || m > 12 || d < 1 ||
+                d > monthDays[m - 1] + unsigned(m == 2 && isLeapYear(y)))
+            {
+                return false;
+            }
+            day = daysFromCivil(static_cast<int>(y), m, d);
+            return true;
         }
-    }
+    } // namespace
 
-    void checkTotalsRow(const str& s)
+    bool parseDate(std::string_view s, const DateFormat& fmt, day_t& day)
     {
-        if (s.find("Total") != str::npos)
+        const auto first = s.find_first_not_of(" \t");
+        if (first == std::string_view::npos)
         {
-            throw brlib::parse::TotalsRowError();
+            return false;
+        }
+        s = s.substr(first, s.find_last_not_of(" \t") - first + 1);
+        switch (fmt.sep)
+        {
+            case '-':
+                return fmt.yearDigits == 2 ? decodeDate<'-', 2>(s, day) :
+                                             decodeDate<'-', 4>(s, day);
+            case '/':
+                return fmt.yearDigits == 2 ? decodeDate<'/', 2>(s, day) :
+                                             decodeDate<'/', 4>(s, day);
+            default:
+                return false;
         }
     }
 
-    EntryBase parseWithAutoConfig(str& s, EntryBase::EntryFrom from,
-                                  AutoParseSettings& options, bool& badDate)
+    namespace
     {
+        inline bool startsWithNoCase(std::string_view s, std::string_view prefix)
+        {
+            if (s.size() < prefix.size())
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i != prefix.size(); ++i)
+            {
+                if ((s[i] | 0x20) != (prefix[i] | 0x20))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
 
-        /* get substring from position */
-        auto getSubstr = [&](const unsigned int& pos) {
-            str ret, sub;
+        inline void trimSpaces(std::string_view& s)
+        {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+            {
+                s.remove_prefix(1);
+            }
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+            {
+                s.remove_suffix(1);
+            }
+        }
 
-            /* return empty string if we're trying to index out of bounds */
-            if (pos >= s.size())
+        /* drop a leading currency marker: ₹, Rs, Rs., INR or $ */
+        inline void skipCurrency(std::string_view& s)
+        {
+            static constexpr std::string_view rupeeSign = "\xe2\x82\xb9";
+            if (s.starts_with(rupeeSign))
+            {
+                s.remove_prefix(rupeeSign.size());
+            }
+            else if (startsWithNoCase(s, "inr"))
+            {
+                s.remove_prefix(3);
+            }
+            else if (startsWithNoCase(s, "rs"))
+            {
+                s.remove_prefix(s.size() > 2 && s[2] == '.' ? 3 : 2);
+            }
+            else if (!s.empty() && s.front() == '$')
             {
-                return ret;
+                s.remove_prefix(1);
             }
+            trimSpaces(s);
+        }
+    } // namespace
 
-            /* pos is delim's position; we need str from next char's pos */
-            sub = s.substr(pos + 1);
+    bool parseMoney(std::string_view s, paise_t& paise, DrCr& drCr)
+    {
+        paise = 0;
+        drCr = DrCr::None;
+        trimSpaces(s);
 
-            std::istringstream iss{sub};
-            /* hard to debug this; if quotes exist, and aren't handled */
-            if (iss.peek() == '"')
+        /* Dr / Cr suffix, as in books balances: 1,234.00 Cr */
+        if (s.size() >= 2)
+        {
+            const std::string_view tail = s.substr(s.size() - 2);
+            if (startsWithNoCase(tail, "cr"))
             {
-                iss >> std::quoted(ret);
+                drCr = DrCr::Cr;
             }
-            else
+            else if (startsWithNoCase(tail, "dr"))
             {
-                getline(iss, ret, options.delimChar);
+                drCr = DrCr::Dr;
             }
-            iss.clear();
-            return ret;
-        };
+            if (drCr != DrCr::None)
+            {
+                s.remove_suffix(2);
+                if (!s.empty() && s.back() == '.')
+                {
+                    s.remove_suffix(1);
+                }
+                trimSpaces(s);
+            }
+        }
 
-        checkTotalsRow(s);
-        unsigned rowDelimsCount = getDelimsBefore(s, s.size() - 1, options.delimChar);
-        unsigned delimCountDiff = rowDelimsCount - options.headerDelimsCount;
-        /** position of last delim char in string, given the number of delim chars as
-   * param. */
-        auto pos = [&](long cnt) {
-            return getDelimPos(s, cnt, options.delimChar);
-        };
+        bool negative = false;
+        if (!s.empty() && s.front() == '(' && s.back() == ')')
+        {
+            negative = true;
+            s.remove_prefix(1);
+            s.remove_suffix(1);
+            trimSpaces(s);
+        }
+        /* sign may sit either side of the currency marker: -₹5 or ₹-5 */
+        for (int pass = 0; pass != 2; ++pass)
+        {
+            if (!s.empty() && (s.front() == '-' || s.front() == '+'))
+            {
+                negative ^= s.front() == '-';
+                s.remove_prefix(1);
+                trimSpaces(s);
+            }
+            if (!pass)
+            {
+                skipCurrency(s);
+            }
+        }
+        if (!s.empty() && s.back() == '-')
+        {
+            negative = !negative;
+            s.remove_suffix(1);
+            trimSpaces(s);
+        }
 
-        /* use common variables `lastDelimPos` and `valueStr` throughout */
-        unsigned long lastDelimPos = pos(options.delimsBefore.date);
+        /* placeholders like "-" or a bare currency sign stand for nothing */
+        if (s.empty())
+        {
+            return true;
+        }
 
-        const str& format = options.dateFormat.value;
-        str valueStr = getSubstr(lastDelimPos);
-        istringstream dtStrm{valueStr};
-        std::tm date{parseDate(dtStrm, format)};
-        badDate = dtStrm.fail();
-#ifdef __linux__
-        /** this directive is needed in parsing date.
-   * When year component length of date is 2 [i.e. %y]; gcc/clang need addition
-   * of 100y, while windows doesn't. catch formats with %y, let those with %Y
-   * slide. */
-        if (format.find('y') != str::npos)
+        constexpr paise_t maxRupees = std::numeric_limits<paise_t>::max() / 100 - 1;
+        paise_t rupees = 0;
+        std::size_t i = 0;
+        bool sawDigit = false;
+        /* integer part; group separators may only sit between digits, which
+         * covers both 1,00,000 and 100,000 */
+        for (; i != s.size() && s[i] != '.'; ++i)
         {
-            date.tm_year += 100;
+            const char c = s[i];
+            if (c >= '0' && c <= '9')
+            {
+                if (rupees > (maxRupees - (c - '0')) / 10)
+                {
+                    return false;
+                }
+                rupees = rupees * 10 + (c - '0');
+                sawDigit = true;
+            }
+            else if (c != ',' || !sawDigit || i + 1 == s.size() || s[i + 1] < '0' ||
+                     s[i + 1] > '9')
+            {
+                return false;
+            }
         }
-#else
-#endif
 
-        long debit, credit, balance;
-        if (!options.singleAmountCol)
+        paise_t fraction = 0;
+        if (i != s.size())
         {
-            /* debit */
-            lastDelimPos = pos(options.delimsBefore.debit + delimCountDiff);
-            valueStr = getSubstr(lastDelimPos);
-            debit = checkZero(valueStr);
+            /* skip the point; keep 2 digits, round on the third */
+            ++i;
+            unsigned digits = 0;
+            for (; i != s.size(); ++i, ++digits)
+            {
+                const char c = s[i];
+                if (c < '0' || c > '9')
+                {
+                    return false;
+                }
+                if (digits < 2)
+                {
+                    fraction = fraction * 10 + (c - '0');
+                }
+                else if (digits == 2 && c >= '5')
+                {
+                    ++fraction;
+                }
+                sawDigit = true;
+            }
+            if (digits == 1)
+            {
+                fraction *= 10;
+            }
+        }
+        if (!sawDigit)
+        {
+            return false;
+        }
+        paise = rupees * 100 + fraction;
+        if (negative)
+        {
+            paise = -paise;
+        }
+        return true;
+    }
+
+    paise_t toPaise(std::string_view s)
+    {
+        paise_t paise;
+        DrCr drCr;
+        if (!parseMoney(s, paise, drCr))
+        {
+            throw AmountParseError(str(s));
+        }
+        return paise;
+    }
+
+    /** balance may have a Cr or Dr suffix in case of books data. */
+    paise_t getBalance(std::string_view s)
+    {
+        paise_t paise;
+        DrCr drCr;
+        if (!parseMoney(s, paise, drCr))
+        {
+            throw AmountParseError(str(s));
+        }
+        return drCr == DrCr::Cr ? -paise : paise; // cr balance in books == -ve
+    }
+
+    void checkTotalsRow(std::string_view s)
+    {
+        if (s.find("Total") != str::npos)
+        {
+            throw brlib::parse::TotalsRowError();
+        }
+    }
+
+    EntryBase parseWithAutoConfig(std::string_view s, EntryBase::EntryFrom from,
+                                  const AutoParseSettings& options, bool& badDate)
+    {
+        return parseWithAutoConfig(RowFields(s, options.delimChar), from, options, badDate);
+    }
+
+    EntryBase parseWithAutoConfig(const RowFields& fields, EntryBase::EntryFrom from,
+                                  const AutoParseSettings& options, bool& badDate)
+    {
+        checkTotalsRow(fields.row());
+        /* columns after a field the header doesn't have shift right by the
+         * number of extra delims in this row */
+        unsigned delimCountDiff = unsigned(fields.delimCount()) - options.headerDelimsCount;
+        /** value of the field with cnt delim chars before it. */
+        auto field = [&](long cnt) {
+            return fields[static_cast<std::size_t>(cnt)];
+        };
+
+        day_t day{};
+        badDate = !parseDate(field(options.delimsBefore.date), options.dateFormat, day);
 
-            /* credit */
-            lastDelimPos = pos(options.delimsBefore.credit + delimCountDiff);
-            valueStr = getSubstr(lastDelimPos);
-            credit = checkZero(valueStr);
+        paise_t debit, credit, balance;
+        if (!options.singleAmountCol)
+        {
+            debit = checkZero(field(options.delimsBefore.debit + delimCountDiff));
+            credit = checkZero(field(options.delimsBefore.credit + delimCountDiff));
         }
         else
         {
-            lastDelimPos = pos(options.delimsBefore.transType + delimCountDiff);
-            valueStr = getSubstr(lastDelimPos);
-            lastDelimPos = pos(options.delimsBefore.amount + delimCountDiff);
-            if (valueStr.find('D') == str::npos)
+            const std::string_view trxType =
+              field(options.delimsBefore.transType + delimCountDiff);
+            const paise_t amount = checkZero(field(options.delimsBefore.amount + delimCountDiff));
+            if (trxType.find('D') == str::npos)
             {
-                valueStr = getSubstr(lastDelimPos);
-                credit = checkZero(valueStr);
+                credit = amount;
                 debit = 0;
             }
             else
             {
-                valueStr = getSubstr(lastDelimPos);
-                debit = checkZero(valueStr);
+                debit = amount;
                 credit = 0;
             }
         }
@@ -427,25 +610,29 @@ namespace brlib::parse
         /* throw errors if needed */
         EntryBase::validate(debit, credit);
 
-        /* balance */
-        lastDelimPos = pos(options.delimsBefore.balance + delimCountDiff);
-        valueStr = getSubstr(lastDelimPos);
-        balance = getBalance(valueStr);
+        balance = getBalance(field(options.delimsBefore.balance + delimCountDiff));
 
-        /* narr */
-        lastDelimPos = pos(options.delimsBefore.narr);
-        str narr = getSubstr(lastDelimPos);
+        /* narr; the only string copied out of the row */
+        str narr(field(options.delimsBefore.narr));
 
-        return {from, date, narr, debit, credit, balance};
+        return {from, day, std::move(narr), debit, credit, balance};
     }
 
-    /** stream the value substrings into a vector, and use the provided positions to
+    /** split the row into views of its columns, and use the provided positions to
  * extract values */
-    EntryBase parseWithManualConfig(str& s, EntryBase::EntryFrom from,
+    EntryBase parseWithManualConfig(std::string_view s, EntryBase::EntryFrom from,
+                                    const ManualParseSettings& options,
+                                    bool& badDate)
+    {
+        return parseWithManualConfig(RowFields(s, options.delimChar), from, options,
+                                     badDate);
+    }
+
+    /** use the provided positions to fetch the row's columns by index */
+    EntryBase parseWithManualConfig(const RowFields& fields, EntryBase::EntryFrom from,
                                     const ManualParseSettings& options,
                                     bool& badDate)
     {
-        vec<str> cols = parseDelimitedRecord(s, options.delimChar);
         using pr_t = ManualParseSettings::col_pr_t;
         typedef decltype(options.colIndices) map_t;
         const map_t& colIndices = options.colIndices;
@@ -455,8 +642,8 @@ namespace brlib::parse
               return lhs.second < rhs.second;
           });
 
-        checkTotalsRow(s);
-        if (maxColPr->second > cols.size())
+        checkTotalsRow(fields.row());
+        if (maxColPr->second > fields.size())
         {
             throw ColNumberError("col index exceeds parsed cols size.");
         }
@@ -485,42 +672,23 @@ namespace brlib::parse
         }
 
         auto fromCols = [&](const unsigned& idx) {
-            str _s;
-            std::istringstream iss{cols.at(idx)};
-            iss >> std::quoted(_s);
-            return _s;
+            return fields.trimmed(idx);
         };
 
-        const char* format = options.dateFormat.value.data();
-        str valueStr = fromCols(dateCol);
-        istringstream dtStrm{valueStr};
-        std::tm date{parseDate(dtStrm, format)};
-
-        badDate = dtStrm.fail();
-
-        /* see expln in func parseWithAutoConfig */
-#if !defined(_WIN32)
-        date.tm_year += 100;
-#else
-#endif
+        day_t day{};
+        badDate = !parseDate(fromCols(dateCol), options.dateFormat, day);
 
-        str narr = fromCols(narrCol);
-
-        long debit, credit, amount;
+        paise_t debit, credit, amount;
         if (debitColAvailable)
         {
-            valueStr = fromCols(debitCol);
-            debit = checkZero(valueStr);
-            valueStr = fromCols(creditCol);
-            credit = checkZero(valueStr);
+            debit = checkZero(fromCols(debitCol));
+            credit = checkZero(fromCols(creditCol));
         }
         else
         {
-            valueStr = fromCols(amtCol);
-            amount = checkZero(valueStr);
-            valueStr = fromCols(trxTypeCol);
+            amount = checkZero(fromCols(amtCol));
             /** Looking for the D in DR / CR flag. Should this be hardcoded? */
-            if (valueStr.find('D') == str::npos)
+            if (fromCols(trxTypeCol).find('D') == str::npos)
             {
                 credit = amount;
                 debit = 0;
@@ -532,41 +700,81 @@ namespace brlib::parse
             }
         }
 
-        valueStr = fromCols(balanceCol);
-        long balance = getBalance(valueStr);
+        paise_t balance = getBalance(fromCols(balanceCol));
 
         EntryBase::validate(debit, credit);
 
-        return {from, date, narr, debit, credit, balance};
+        return {from, day, str(fromCols(narrCol)), debit, credit, balance};
     }
 
-    void parseEntries(EntryBase::EntryFrom from, std::fstream& file,
-                      passedAndFailedVecs& vecs, bool autoParse,
-                      ManualParseSettings& options)
+    namespace
     {
-
-        /* if autoparse has been enabled, then parse data format, else, use user
-   * provided settings. */
-        AutoParseSettings autoSettings;
-        int& headerAt = options.headerAt;
-        if (autoParse)
+        /* a row whose date didn't parse, seen before any good row of its chunk.
+         * it takes the date of whatever row precedes the chunk, once known. */
+        struct LeadingRow
         {
-            configureAutoParse(file, autoSettings);
-            headerAt = autoSettings.headerAt;
-        }
+            EntryBase entry;
+            std::string_view raw;
+            /* failed.size() of the chunk when the row was read */
+            std::size_t failedPos;
+        };
 
-        str raw_entry;
-        int cnt;
+        struct ChunkResult
+        {
+            explicit ChunkResult(EntryBase::EntryFrom from):
+                passed(from) {}
+            EntryStore passed;
+            vec<std::string_view> failed;
+            vec<LeadingRow> leading;
+            /* start of the totals row that ended the statement in this chunk */
+            const char* stopAt{nullptr};
+        };
 
-        while (getline(file, raw_entry))
+        /* rows in chunk, from the width of its first few lines and a little
+         * over, so the columns are mostly sized once without a pass over the
+         * whole chunk; push_back covers an underestimate */
+        std::size_t estimateRows(std::string_view chunk)
         {
-            // valgrind showed error here: 'conditional jump or move depends on uninitialized value(s)'
-            if (cnt++ <= headerAt || raw_entry.find(options.delimChar) == str::npos)
+            constexpr std::size_t sampleLines = 64;
+            std::size_t lines = 0, pos = 0;
+            while (lines != sampleLines && pos < chunk.size())
             {
-                continue;
+                const std::size_t nl = chunk.find('\n', pos);
+                pos = nl == std::string_view::npos ? chunk.size() : nl + 1;
+                ++lines;
             }
-            else
+            if (pos >= chunk.size())
+            {
+                return lines;
+            }
+            return chunk.size() * lines / pos * 9 / 8 + 1;
+        }
+
+        ChunkResult parseChunk(EntryBase::EntryFrom from, std::string_view chunk,
+                               bool autoParse, const AutoParseSettings& autoSettings,
+                               const ManualParseSettings& options, char delimChar,
+                               Progress* progress)
+        {
+            ChunkResult res(from);
+            res.passed.reserve(estimateRows(chunk));
+
+            RowFields fields;
+            std::string_view rest = chunk;
+            std::size_t lines = 0, reported = 0;
+            while (!rest.empty())
             {
+                if (progress && ++lines % Progress::stride == 0)
+                {
+                    const std::size_t done = chunk.size() - rest.size();
+                    progress->bytesParsed += done - reported;
+                    reported = done;
+                    progress->check();
+                }
+                const std::string_view raw_entry = nextLine(rest);
+                if (raw_entry.find(delimChar) == str::npos)
+                {
+                    continue;
+                }
                 try
                 {
                     /* for case where 2 separate lines form 1 entry
@@ -575,59 +783,392 @@ namespace brlib::parse
          * and copy it over. */
                     bool badDate{false};
                     EntryBase entry;
+                    fields.split(raw_entry, delimChar);
                     if (autoParse)
                     {
-                        entry = parseWithAutoConfig(raw_entry, from, autoSettings, badDate);
+                        entry = parseWithAutoConfig(fields, from, autoSettings, badDate);
                     }
                     else
                     {
-                        entry = parseWithManualConfig(raw_entry, from, options, badDate);
+                        entry = parseWithManualConfig(fields, from, options, badDate);
                     }
                     if (badDate)
                     {
-                        if (!vecs.passed->empty())
-                        {
-                            entry.date = vecs.passed->back().date;
-                        }
-                        else
+                        if (res.passed.empty())
                         {
-                            vecs.failed->push_back(raw_entry);
+                            res.leading.push_back({std::move(entry), raw_entry, res.failed.size()});
                             continue;
                         }
+                        entry.date = res.passed.day(res.passed.size() - 1);
                     }
-                    vecs.passed->push_back(entry);
+                    res.passed.push_back(entry);
                 }
                 catch (TotalsRowError& e)
                 {
-                    fprintf(stderr, "Stopping parse; found totals row: %s\n",
-                            raw_entry.data());
+                    fprintf(stderr, "Stopping parse; found totals row: %.*s\n",
+                            int(raw_entry.size()), raw_entry.data());
+                    res.stopAt = raw_entry.data();
                     break;
                 }
                 catch (ColNumberError& e)
                 {
-                    fprintf(stderr, "parsing error: %s \n\t raw_entry: %s\n", e.what(),
-                            raw_entry.data());
-                    vecs.failed->push_back(raw_entry);
+                    fprintf(stderr, "parsing error: %s \n\t raw_entry: %.*s\n", e.what(),
+                            int(raw_entry.size()), raw_entry.data());
+                    res.failed.push_back(raw_entry);
                 }
                 catch (DebitCreditError& e)
                 {
-                    fprintf(stderr, "logic error: %s\n%s\n", e.what(), raw_entry.data());
-                    vecs.failed->push_back(raw_entry);
+                    fprintf(stderr, "logic error: %s\n%.*s\n", e.what(),
+                            int(raw_entry.size()), raw_entry.data());
+                    res.failed.push_back(raw_entry);
+                }
+                catch (AmountParseError& e)
+                {
+                    fprintf(stderr, "parsing error: %s\n%.*s\n", e.what(),
+                            int(raw_entry.size()), raw_entry.data());
+                    res.failed.push_back(raw_entry);
                 }
                 catch (BalanceParsingError& e)
                 {
-                    fprintf(stderr, "parsing error: %s\n%s\n", e.what(), raw_entry.data());
-                    vecs.failed->push_back(raw_entry);
+                    fprintf(stderr, "parsing error: %s\n%.*s\n", e.what(),
+                            int(raw_entry.size()), raw_entry.data());
+                    res.failed.push_back(raw_entry);
                 }
                 catch (std::exception& e)
                 {
-                    file.close();
-                    fprintf(stderr, "unhandled error for entry: %s\n\t%s\n",
-                            raw_entry.data(), e.what());
+                    fprintf(stderr, "unhandled error for entry: %.*s\n\t%s\n",
+                            int(raw_entry.size()), raw_entry.data(), e.what());
                     throw;
                 }
             }
+            if (progress)
+            {
+                progress->bytesParsed += chunk.size() - reported;
+            }
+            return res;
+        }
+
+        /* append a chunk's rows in file order. leading rows take the date of the
+         * last row stitched so far, else lastDay, or fail if there's neither, as
+         * they would have when parsed in one pass. */
+        void stitchChunk(ChunkResult& chunk, passedAndFailedVecs& vecs,
+                         std::optional<day_t> lastDay)
+        {
+            EntryStore& passed = *vecs.passed;
+            vec<str>& failed = *vecs.failed;
+            auto leadIt = chunk.leading.begin();
+            for (std::size_t i = 0; i <= chunk.failed.size(); ++i)
+            {
+                for (; leadIt != chunk.leading.end() && leadIt->failedPos == i; ++leadIt)
+                {
+                    if (!passed.empty())
+                    {
+                        lastDay = passed.day(passed.size() - 1);
+                    }
+                    if (!lastDay)
+                    {
+                        failed.emplace_back(leadIt->raw);
+                    }
+                    else
+                    {
+                        leadIt->entry.date = *lastDay;
+                        passed.push_back(leadIt->entry);
+                    }
+                }
+                if (i < chunk.failed.size())
+                {
+                    failed.emplace_back(chunk.failed[i]);
+                }
+            }
+            passed.append(chunk.passed);
+        }
+
+        /* split body into about parts pieces, each ending on a line break. a
+         * break is only taken where the line before it has balanced quotes, so
+         * a quoted field running over lines stays in one piece. */
+        vec<std::string_view> splitAtRowBoundaries(std::string_view body, std::size_t parts)
+        {
+            vec<std::string_view> chunks;
+            chunks.reserve(parts);
+            const std::size_t target = body.size() / parts;
+            std::size_t begin = 0;
+            while (chunks.size() + 1 < parts && begin + target < body.size())
+            {
+                std::size_t lineBegin = body.rfind('\n', begin + target);
+                lineBegin = (lineBegin == str::npos || lineBegin < begin) ? begin : lineBegin + 1;
+                std::size_t end = str::npos;
+                while (lineBegin < body.size())
+                {
+                    const std::size_t nl = body.find('\n', lineBegin);
+                    if (nl == str::npos)
+                    {
+                        break;
+                    }
+                    const std::string_view line = body.substr(lineBegin, nl - lineBegin);
+                    lineBegin = nl + 1;
+                    if (std::count(line.begin(), line.end(), '"') % 2 == 0)
+                    {
+                        end = lineBegin;
+                        break;
+                    }
+                }
+                if (end == str::npos || end >= body.size())
+                {
+                    break;
+                }
+                chunks.push_back(body.substr(begin, end - begin));
+                begin = end;
+            }
+            chunks.push_back(body.substr(begin));
+            return chunks;
+        }
+
+        /* FNV-1a; only compared with hashes of the same process' parses */
+        std::uint64_t hashBytes(std::string_view s)
+        {
+            std::uint64_t h = 0xcbf29ce484222325ULL;
+            for (const char c : s)
+            {
+                h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+            }
+            return h;
         }
+
+        /* data[0, end) as consumed, identified by its last line */
+        ParsedPrefix prefixOf(std::string_view data, std::size_t end)
+        {
+            ParsedPrefix prefix{end, 0, 0};
+            const std::size_t lineEnd = end && data[end - 1] == '\n' ? end - 1 : end;
+            const std::size_t nl = lineEnd ? data.rfind('\n', lineEnd - 1) : str::npos;
+            prefix.lastLineBegin = nl == str::npos ? 0 : nl + 1;
+            prefix.lastLineHash =
+              hashBytes(data.substr(prefix.lastLineBegin, end - prefix.lastLineBegin));
+            return prefix;
+        }
+
+        /* column layout from data's header if autoParse, else options; the
+         * delimiter rows are split on */
+        char configure(std::string_view data, bool autoParse, ManualParseSettings& options,
+                       AutoParseSettings& autoSettings)
+        {
+            /* if autoparse has been enabled, then parse data format, else, use user
+             * provided settings. */
+            if (autoParse)
+            {
+                configureAutoParse(data, autoSettings);
+                options.headerAt = autoSettings.headerAt;
+            }
+            return autoParse ? autoSettings.delimChar : options.delimChar;
+        }
+
+        /* parse body, a run of whole rows inside data, onto the end of vecs and
+         * record how much of data has been consumed. lastDay is that of the row
+         * before body, if vecs doesn't hold it. */
+        void parseBody(EntryBase::EntryFrom from, std::string_view data,
+                       std::string_view body, passedAndFailedVecs& vecs, bool autoParse,
+                       const AutoParseSettings& autoSettings,
+                       const ManualParseSettings& options, char delimChar,
+                       const ParallelParseSettings& parallel, Progress* progress,
+                       std::optional<day_t> lastDay = std::nullopt)
+        {
+            if (progress)
+            {
+                /* the header, or the rows vecs already hold */
+                progress->bytesParsed += std::size_t(body.data() - data.data());
+            }
+            unsigned threads = parallel.threads;
+            if (!threads)
+            {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            const std::size_t parts = std::clamp<std::size_t>(
+              body.size() / std::max<std::size_t>(parallel.minChunkBytes, 1), 1, threads);
+
+            vec<std::string_view> chunks = splitAtRowBoundaries(body, parts);
+            vec<std::future<ChunkResult>> pending;
+            pending.reserve(chunks.size());
+            for (std::size_t i = 1; i < chunks.size(); ++i)
+            {
+                pending.push_back(ThreadPool::shared().submit([&, i]() {
+                    return parseChunk(from, chunks[i], autoParse, autoSettings, options,
+                                      delimChar, progress);
+                }));
+            }
+            /* the first chunk runs here while the pool takes the rest. every task
+             * is waited on before anything can throw out, as they view data. */
+            ChunkResult first(from);
+            try
+            {
+                first = parseChunk(from, chunks.front(), autoParse, autoSettings, options,
+                                   delimChar, progress);
+            }
+            catch (...)
+            {
+                for (std::future<ChunkResult>& f : pending)
+                {
+                    f.wait();
+                }
+                throw;
+            }
+            for (std::future<ChunkResult>& f : pending)
+            {
+                f.wait();
+            }
+            /* any chunk's error, a cancel included, surfaces before vecs change */
+            vec<ChunkResult> later;
+            later.reserve(pending.size());
+            for (std::future<ChunkResult>& f : pending)
+            {
+                later.push_back(f.get());
+            }
+
+            stitchChunk(first, vecs, lastDay);
+            const char* stopAt = first.stopAt;
+            for (ChunkResult& chunk : later)
+            {
+                if (!stopAt)
+                {
+                    stitchChunk(chunk, vecs, lastDay);
+                    stopAt = chunk.stopAt;
+                }
+            }
+            vecs.prefix = prefixOf(data, stopAt ? std::size_t(stopAt - data.data()) : data.size());
+        }
+    } // namespace
+
+    void parseEntries(EntryBase::EntryFrom from, std::string_view data,
+                      passedAndFailedVecs& vecs, bool autoParse,
+                      ManualParseSettings& options,
+                      const ParallelParseSettings& parallel, Progress* progress)
+    {
+        AutoParseSettings autoSettings;
+        const char delimChar = configure(data, autoParse, options, autoSettings);
+
+        /* skip the header and anything above it; the rest is rows only */
+        std::string_view body = data;
+        for (int cnt = 0; cnt <= options.headerAt && !body.empty(); ++cnt)
+        {
+            nextLine(body);
+        }
+        parseBody(from, data, body, vecs, autoParse, autoSettings, options, delimChar,
+                  parallel, progress);
+    }
+
+    bool parseAppended(EntryBase::EntryFrom from, std::string_view data,
+                       passedAndFailedVecs& vecs, bool autoParse,
+                       ManualParseSettings& options,
+                       const ParallelParseSettings& parallel, Progress* progress)
+    {
+        return parseAppended(from, data, vecs, vecs, autoParse, options, parallel,
+                             progress);
+    }
+
+    bool parseAppended(EntryBase::EntryFrom from, std::string_view data,
+                       const passedAndFailedVecs& vecs, passedAndFailedVecs& tail,
+                       bool autoParse, ManualParseSettings& options,
+                       const ParallelParseSettings& parallel, Progress* progress)
+    {
+        const ParsedPrefix& prefix = vecs.prefix;
+        if (!prefix.bytes || data.size() < prefix.bytes ||
+            hashBytes(data.substr(prefix.lastLineBegin,
+                                  prefix.bytes - prefix.lastLineBegin)) != prefix.lastLineHash)
+        {
+            return false;
+        }
+        /* a last line without a break must have gained one, not more text */
+        std::size_t resume = prefix.bytes;
+        if (data[resume - 1] != '\n' && resume < data.size())
+        {
+            const std::string_view next = data.substr(resume);
+            if (!next.starts_with('\n') && !next.starts_with("\r\n"))
+            {
+                return false;
+            }
+            resume += next.find('\n') + 1;
+        }
+
+        /* vecs and tail may be the same; read vecs before tail grows */
+        std::optional<day_t> lastDay;
+        if (!vecs.passed->empty())
+        {
+            lastDay = vecs.passed->day(vecs.passed->size() - 1);
+        }
+        AutoParseSettings autoSettings;
+        const char delimChar = configure(data, autoParse, options, autoSettings);
+        parseBody(from, data, data.substr(resume), tail, autoParse, autoSettings, options,
+                  delimChar, parallel, progress, lastDay);
+        return true;
+    }
+
+    void appendParsed(passedAndFailedVecs& vecs, passedAndFailedVecs& tail)
+    {
+        vecs.passed->append(*tail.passed);
+        vecs.failed->insert(vecs.failed->end(), std::make_move_iterator(tail.failed->begin()),
+                            std::make_move_iterator(tail.failed->end()));
+        vecs.prefix = tail.prefix;
+    }
+
+    void parseFile(EntryBase::EntryFrom from, const str& path,
+                   passedAndFailedVecs& vecs, bool autoParse,
+                   ManualParseSettings& options,
+                   const ParallelParseSettings& parallel, Progress* progress)
+    {
+        const MappedFile file(path);
+        parseEntries(from, file.view(), vecs, autoParse, options, parallel, progress);
+    }
+
+    bool parseFileAppended(EntryBase::EntryFrom from, const str& path,
+                           passedAndFailedVecs& vecs, bool autoParse,
+                           ManualParseSettings& options,
+                           const ParallelParseSettings& parallel, Progress* progress)
+    {
+        const MappedFile file(path);
+        return parseAppended(from, file.view(), vecs, autoParse, options, parallel,
+                             progress);
+    }
+
+    bool parseFileAppended(EntryBase::EntryFrom from, const str& path,
+                           const passedAndFailedVecs& vecs, passedAndFailedVecs& tail,
+                           bool autoParse, ManualParseSettings& options,
+                           const ParallelParseSettings& parallel, Progress* progress)
+    {
+        const MappedFile file(path);
+        return parseAppended(from, file.view(), vecs, tail, autoParse, options, parallel,
+                             progress);
+    }
+
+    void parseFiles(const str& bankPath, passedAndFailedVecs& bank,
+                    const str& booksPath, passedAndFailedVecs& books,
+                    ParseSettings& settings)
+    {
+        const bool autoParse = settings.isAutoParseEnabled();
+        /* books on a thread of its own rather than a pool worker, as it waits on
+         * its own chunks in the pool */
+        std::future<void> booksDone = std::async(std::launch::async, [&]() {
+            parseFile(EntryBase::EntryFrom::Books, booksPath, books, autoParse,
+                      settings.books, settings.parallel);
+        });
+        try
+        {
+            parseFile(EntryBase::EntryFrom::Bank, bankPath, bank, autoParse,
+                      settings.bank, settings.parallel);
+        }
+        catch (...)
+        {
+            booksDone.wait();
+            throw;
+        }
+        booksDone.get();
+    }
+
+    void parseEntries(EntryBase::EntryFrom from, std::fstream& file,
+                      passedAndFailedVecs& vecs, bool autoParse,
+                      ManualParseSettings& options)
+    {
+        /* streams can't be mapped; read it whole and parse the buffer */
+        const str data{std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>()};
         file.close();
+        parseEntries(from, std::string_view(data), vecs, autoParse, options);
     }
 } // namespace brlib::parse
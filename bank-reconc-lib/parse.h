@@ -1,7 +1,10 @@
 #ifndef BRLIB_PARSE_H
 #define BRLIB_PARSE_H
 
+#include <string_view>
+
 #include "EntryBase.h"
+#include "EntryStore.h"
 #include "brlib_common.h"
 
 namespace brlib::parse
@@ -34,6 +37,13 @@ namespace brlib::parse
             std::runtime_error("balance doesn't have Dr or Cr") {}
     };
 
+    class AmountParseError : public std::invalid_argument
+    {
+    public:
+        explicit AmountParseError(const str& s):
+            std::invalid_argument("couldn't read amount: " + s) {}
+    };
+
     class InvalidHeaderError : public std::invalid_argument
     {
     public:
@@ -59,38 +69,170 @@ namespace brlib::parse
 
     std::string_view rtrim(std::string_view& s);
 
-    std::tm parseDate(istringstream& iss, const str& fmt);
+    /* split the first line off rest, without its line ending. */
+    std::string_view nextLine(std::string_view& rest);
+
+    /* field value up to the closing quote if quoted, else up to the next delim. */
+    std::string_view unquote(std::string_view s, char delimChar);
 
-    void configureAutoParse(std::fstream& file, AutoParseSettings& options);
+    /** one row split at its delims in a single pass, so any column can be
+     * fetched by index. delims between quotes don't split; a field opening
+     * with a quote runs to the closing one. */
+    class RowFields
+    {
+    public:
+        RowFields() = default;
+        RowFields(std::string_view row, char delimChar) { split(row, delimChar); }
 
-    vec<str> parseDelimitedRecord(const str& s, char delimChar);
+        /* split another row, reusing the position buffer */
+        void split(std::string_view row, char delimChar);
 
-    long toPaise(const str& s);
+        [[nodiscard]] std::string_view row() const { return m_row; }
+        [[nodiscard]] std::size_t delimCount() const { return m_delims.size(); }
+        [[nodiscard]] std::size_t size() const { return m_delims.size() + 1; }
 
-    long checkZero(str& str1);
+        /* index of the field holding pos, i.e. the number of delims before it */
+        [[nodiscard]] std::size_t fieldAt(std::size_t pos) const;
 
-    using sp_vec_entry_t = sp<vec<EntryBase>>;
+        /* field i, unquoted; empty past the last field */
+        [[nodiscard]] std::string_view operator[](std::size_t i) const;
+
+        /* field i, unquoted, without surrounding whitespace */
+        [[nodiscard]] std::string_view trimmed(std::size_t i) const;
+
+    private:
+        std::string_view m_row;
+        char m_delim{','};
+        vec<std::size_t> m_delims;
+    };
+
+    /* decode a date laid out as fmt into a day number; false if it doesn't fit
+     * the layout or isn't a valid calendar date. */
+    bool parseDate(std::string_view s, const DateFormat& fmt, day_t& day);
+
+    void configureAutoParse(std::string_view data, AutoParseSettings& options);
+
+    vec<std::string_view> parseDelimitedRecord(std::string_view s, char delimChar);
+
+    enum class DrCr
+    {
+        None,
+        Dr,
+        Cr
+    };
+
+    /** integer-only amount reader. takes Indian or western digit grouping, an
+     * optional ₹ / Rs / INR / $ marker, a leading or trailing sign, (negatives)
+     * and a Dr / Cr suffix, which is reported in drCr rather than applied.
+     * false if s isn't an amount; an empty field reads as 0. */
+    bool parseMoney(std::string_view s, paise_t& paise, DrCr& drCr);
+
+    /* amount in paise, ignoring any Dr / Cr suffix. throws AmountParseError. */
+    paise_t toPaise(std::string_view s);
+
+    /* amount in paise, negative for Cr. throws AmountParseError. */
+    paise_t getBalance(std::string_view s);
+
+    paise_t checkZero(std::string_view s);
+
+    using sp_vec_entry_t = sp<EntryStore>;
+
+    /* how much of its input a parse consumed, so that a longer copy of the
+     * same input can be parsed from where this one stopped. */
+    struct ParsedPrefix
+    {
+        /* bytes consumed: everything, or up to the start of a totals row */
+        std::size_t bytes{0};
+        /* the last line inside bytes, and its hash */
+        std::size_t lastLineBegin{0};
+        std::uint64_t lastLineHash{0};
+    };
 
     struct passedAndFailedVecs
     {
         passedAndFailedVecs():
-            passed(std::make_shared<vec<EntryBase>>()),
+            passed(std::make_shared<EntryStore>()),
             failed(std::make_shared<vec<str>>()) {}
         sp_vec_entry_t passed;
         sp<vec<str>> failed;
+        ParsedPrefix prefix;
     };
-    EntryBase parseWithAutoConfig(str& s, EntryBase::EntryFrom from,
-                                  AutoParseSettings& options, bool& badDate);
+    EntryBase parseWithAutoConfig(std::string_view s, EntryBase::EntryFrom from,
+                                  const AutoParseSettings& options, bool& badDate);
+    EntryBase parseWithAutoConfig(const RowFields& fields, EntryBase::EntryFrom from,
+                                  const AutoParseSettings& options, bool& badDate);
 
-    EntryBase parseWithManualConfig(str& s, EntryBase::EntryFrom from,
+    EntryBase parseWithManualConfig(std::string_view s, EntryBase::EntryFrom from,
                                     const ManualParseSettings& options,
                                     bool& badDate);
+    EntryBase parseWithManualConfig(const RowFields& fields, EntryBase::EntryFrom from,
+                                    const ManualParseSettings& options,
+                                    bool& badDate);
+
+    /* parse rows of data, i.e. a whole file's contents; views into data are
+     * only held while parsing. large inputs are split at row boundaries and
+     * parsed on ThreadPool::shared(); rows come out in file order either way.
+     * with progress, bytes are counted as chunks go and a cancel throws
+     * Cancelled, leaving vecs as they were. */
+    void parseEntries(EntryBase::EntryFrom from, std::string_view data,
+                      passedAndFailedVecs& vecs, bool autoParse,
+                      ManualParseSettings& options,
+                      const ParallelParseSettings& parallel = {},
+                      Progress* progress = nullptr);
+
+    /** parse only what was appended to data since vecs were parsed from a
+     * shorter copy of it, e.g. a statement exported again later in the month.
+     * the copy is recognised by vecs.prefix: data must be at least as long and
+     * hold the same last line at the same offset. false, with vecs untouched,
+     * if it doesn't; the caller parses data whole instead. */
+    bool parseAppended(EntryBase::EntryFrom from, std::string_view data,
+                       passedAndFailedVecs& vecs, bool autoParse,
+                       ManualParseSettings& options,
+                       const ParallelParseSettings& parallel = {},
+                       Progress* progress = nullptr);
+
+    /** parseAppended with the appended rows going to tail, which starts empty;
+     * vecs is only read, so it can be shown meanwhile. appendParsed then puts
+     * them after vecs' rows. */
+    bool parseAppended(EntryBase::EntryFrom from, std::string_view data,
+                       const passedAndFailedVecs& vecs, passedAndFailedVecs& tail,
+                       bool autoParse, ManualParseSettings& options,
+                       const ParallelParseSettings& parallel = {},
+                       Progress* progress = nullptr);
+
+    /* move tail's rows onto the end of vecs and take its prefix. costs tail's
+     * rows, plus vecs' if its store is still mapped (see EntryStore). */
+    void appendParsed(passedAndFailedVecs& vecs, passedAndFailedVecs& tail);
+
+    /* map the file at path and parse it in place. throws FileOpenError. */
+    void parseFile(EntryBase::EntryFrom from, const str& path,
+                   passedAndFailedVecs& vecs, bool autoParse,
+                   ManualParseSettings& options,
+                   const ParallelParseSettings& parallel = {},
+                   Progress* progress = nullptr);
+
+    /* parseAppended over the file at path. throws FileOpenError. */
+    bool parseFileAppended(EntryBase::EntryFrom from, const str& path,
+                           passedAndFailedVecs& vecs, bool autoParse,
+                           ManualParseSettings& options,
+                           const ParallelParseSettings& parallel = {},
+                           Progress* progress = nullptr);
+    bool parseFileAppended(EntryBase::EntryFrom from, const str& path,
+                           const passedAndFailedVecs& vecs, passedAndFailedVecs& tail,
+                           bool autoParse, ManualParseSettings& options,
+                           const ParallelParseSettings& parallel = {},
+                           Progress* progress = nullptr);
+
+    /* parse a bank and a books file concurrently. */
+    void parseFiles(const str& bankPath, passedAndFailedVecs& bank,
+                    const str& booksPath, passedAndFailedVecs& books,
+                    ParseSettings& settings);
 
     void parseEntries(EntryBase::EntryFrom from, std::fstream& file,
                       passedAndFailedVecs& vecs, bool autoParse,
                       ManualParseSettings& options);
 
-    void checkTotalsRow(const str& s);
+    void checkTotalsRow(std::string_view s);
 
 } // namespace brlib::parse
 
@@ -1,62 +1,434 @@
 #include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
+#include <numeric>
 #include <set>
+#include <span>
+#include <unordered_map>
 
 #include "EntryMatch.h"
+#include "MatchEngine.h"
+#include "RelatedSearch.h"
+#include "ThreadPool.h"
 #include "reconcile.h"
 
 namespace brlib
 {
 
-    /* Todo: edge cases:
- *  - no entries in file
- */
-
-    pr_vec_t findLastMatchingBalance(passedAndFailedVecs& lhs,
-                                     passedAndFailedVecs& rhs)
+    /** latest rows at which both files show the same closing balance.
+     * books balances are indexed by value once, each books row linked to the
+     * previous one with the same balance, and bank rows are walked from the end;
+     * the first bank balance books has, paired with the latest books row with
+     * it, is the anchor. with confirmRows, the bank rows before a candidate must
+     * also have balances books shows before it, in the same order, or the
+     * candidate is skipped as a chance equality. linear in both files, plus the
+     * confirmation walks. (0, 0) if there is no anchor. */
+    pr_vec_t findLastMatchingBalance(const passedAndFailedVecs& lhs,
+                                     const passedAndFailedVecs& rhs,
+                                     unsigned confirmRows)
     {
         pr_vec_t pr = std::make_pair(0, 0);
-        if (!lhs.passed->empty() && !rhs.passed->empty())
+        if (!lhs.passed || !rhs.passed || lhs.passed->empty() || rhs.passed->empty())
+        {
+            return pr;
+        }
+        const std::span<const paise_t> bank = lhs.passed->balances();
+        const std::span<const paise_t> books = rhs.passed->balances();
+        constexpr entry_vec_sz_t none = MatchEngine::npos;
+
+        std::unordered_map<paise_t, entry_vec_sz_t> latest;
+        latest.reserve(books.size());
+        vec<entry_vec_sz_t> previous(books.size(), none);
+        for (entry_vec_sz_t i = 0; i < books.size(); ++i)
+        {
+            auto [it, inserted] = latest.try_emplace(books[i], i);
+            if (!inserted)
+            {
+                previous[i] = it->second;
+                it->second = i;
+            }
+        }
+        /* latest books row before `before` with this balance, or none */
+        auto bookRowBefore = [&](paise_t balance, entry_vec_sz_t before) {
+            const auto it = latest.find(balance);
+            entry_vec_sz_t i = it == latest.end() ? none : it->second;
+            while (i != none && i >= before)
+            {
+                i = previous[i];
+            }
+            return i;
+        };
+
+        for (entry_vec_sz_t bankIdx = bank.size(); bankIdx-- > 0;)
+        {
+            const entry_vec_sz_t bookIdx = bookRowBefore(bank[bankIdx], books.size());
+            if (bookIdx == none)
+            {
+                continue;
+            }
+            bool confirmed = true;
+            entry_vec_sz_t booksAt = bookIdx;
+            for (unsigned k = 1; confirmed && k <= confirmRows; ++k)
+            {
+                confirmed = k <= bankIdx &&
+                            (booksAt = bookRowBefore(bank[bankIdx - k], booksAt)) != none;
+            }
+            if (confirmed)
+            {
+                pr.first = bankIdx;
+                pr.second = bookIdx;
+                return pr;
+            }
+        }
+        return pr;
+    }
+
+    namespace
+    {
+        /* size the matched bitmaps to the passed vecs, keeping bits already set. */
+        void sizeMatchedBitmaps(const passedAndFailedVecs& bank, const passedAndFailedVecs& book,
+                                results_t& results)
+        {
+            if (bank.passed && results.bankMatched.size() < bank.passed->size())
+            {
+                results.bankMatched.resize(bank.passed->size(), false);
+            }
+            if (book.passed && results.booksMatched.size() < book.passed->size())
+            {
+                results.booksMatched.resize(book.passed->size(), false);
+            }
+        }
+
+        /* push books entries that aren't part of any match to missingInBank, in one
+         * pass over the matched-books bitmap. */
+        void collectMissingInBank(const passedAndFailedVecs& bank, const passedAndFailedVecs& book,
+                                  results_t& results)
         {
-            entry_vec_sz_t bank_r_idx = lhs.passed->size() - 1, bank_r_end = 0,
-                           book_r_idx = rhs.passed->size() - 1, book_r_end = 0;
-            for (; bank_r_idx != bank_r_end; --bank_r_idx)
+            if (book.passed && bank.passed && !book.passed->empty())
             {
-                for (; book_r_idx != book_r_end; --book_r_idx)
+                const vec<bool>& matched = results.booksMatched;
+                for (entry_vec_sz_t booksIdx = 0, booksEnd = book.passed->size();
+                     booksIdx != booksEnd; ++booksIdx)
                 {
-                    if (lhs.passed->at(bank_r_idx).balance ==
-                        rhs.passed->at(book_r_idx).balance)
+                    if (!matched[booksIdx])
                     {
-                        pr.first = bank_r_idx;
-                        pr.second = book_r_idx;
-                        return pr;
+                        results.missingInBank.push_back(booksIdx);
                     }
                 }
             }
         }
-        return pr;
-    }
+
+        bool hasDateTolerance(const ReconcileSettings& settings)
+        {
+            return settings.booksDaysEarly > 0 || settings.booksDaysLate > 0;
+        }
+
+        vec<entry_vec_sz_t> rowsFrom(const EntryStore& entries, entry_vec_sz_t begin)
+        {
+            vec<entry_vec_sz_t> rows(begin < entries.size() ? entries.size() - begin : 0);
+            std::iota(rows.begin(), rows.end(), begin);
+            return rows;
+        }
+
+        /** match bankRows against booksRows, both ascending: an exact pass over
+         * MatchEngine, then, with a date tolerance, the leftovers through
+         * DateWindowEngine. matches are appended in bank order, and unmatched
+         * bank rows to missingInBook. missingInBank is left to the caller. */
+        void matchRows(const sp<EntryStore>& bank, const vec<entry_vec_sz_t>& bankRows,
+                       const sp<EntryStore>& books, const vec<entry_vec_sz_t>& booksRows,
+                       results_t& results, const ReconcileSettings& settings,
+                       Progress* progress)
+        {
+            /* books idx each bank row pairs with, so matches come out in bank
+             * order however many passes found them */
+            vec<entry_vec_sz_t> paired(bankRows.size(), MatchEngine::npos);
+            vec<std::size_t> unpaired;
+            {
+                MatchEngine engine(*books, booksRows);
+                for (std::size_t r = 0; r < bankRows.size(); ++r)
+                {
+                    if (progress && r % Progress::stride == 0)
+                    {
+                        progress->check();
+                    }
+                    const entry_vec_sz_t bookIdx = engine.take(*bank, bankRows[r]);
+                    if (bookIdx != MatchEngine::npos)
+                    {
+                        paired[r] = bookIdx;
+                        results.booksMatched[bookIdx] = true;
+                    }
+                    else
+                    {
+                        unpaired.push_back(r);
+                    }
+                }
+            }
+            if (hasDateTolerance(settings) && !unpaired.empty())
+            {
+                vec<entry_vec_sz_t> leftover;
+                for (const entry_vec_sz_t i : booksRows)
+                {
+                    if (!results.booksMatched[i])
+                    {
+                        leftover.push_back(i);
+                    }
+                }
+                DateWindowEngine engine(*books, std::move(leftover), settings.booksDaysEarly,
+                                        settings.booksDaysLate);
+                for (const std::size_t r : unpaired)
+                {
+                    const entry_vec_sz_t bookIdx = engine.take(*bank, bankRows[r]);
+                    if (bookIdx != DateWindowEngine::npos)
+                    {
+                        paired[r] = bookIdx;
+                        results.booksMatched[bookIdx] = true;
+                    }
+                }
+            }
+
+            for (std::size_t r = 0; r < bankRows.size(); ++r)
+            {
+                if (progress && r && r % Progress::stride == 0)
+                {
+                    progress->rowsMatched += Progress::stride;
+                    progress->check();
+                }
+                const entry_vec_sz_t bankIdx = bankRows[r];
+                if (paired[r] != MatchEngine::npos)
+                {
+                    EntryMatch m({}, bank, books);
+                    m.insertIntoBank(bankIdx, results);
+                    m.insertIntoBooks(paired[r], results);
+                    results.matches.push_back(m);
+                    results.bankMatched[bankIdx] = true;
+                }
+                else
+                {
+                    results.missingInBook.push_back(bankIdx);
+                }
+            }
+            if (progress && !bankRows.empty())
+            {
+                progress->rowsMatched += (bankRows.size() - 1) % Progress::stride + 1;
+            }
+        }
+
+        /* compare what both engines appended to their results, and describe the
+         * first difference found. empty string if they agree. */
+        str diffResults(const results_t& lhs, const results_t& rhs)
+        {
+            ostringstream oss;
+            if (lhs.matches.size() != rhs.matches.size())
+            {
+                oss << "matches: " << lhs.matches.size() << " vs " << rhs.matches.size();
+                return oss.str();
+            }
+            for (vec<EntryMatch>::size_type i = 0; i != lhs.matches.size(); ++i)
+            {
+                const vec<EntryPointer>& l = lhs.matches[i].data();
+                const vec<EntryPointer>& r = rhs.matches[i].data();
+                bool same = l.size() == r.size();
+                for (vec<EntryPointer>::size_type j = 0; same && j != l.size(); ++j)
+                {
+                    same = l[j].entryFor == r[j].entryFor && l[j].entryIdx == r[j].entryIdx;
+                }
+                if (!same)
+                {
+                    oss << "match #" << i << " differs";
+                    return oss.str();
+                }
+            }
+            if (lhs.missingInBook != rhs.missingInBook)
+            {
+                oss << "missingInBook: " << lhs.missingInBook.size() << " vs "
+                    << rhs.missingInBook.size() << " entries";
+                return oss.str();
+            }
+            if (lhs.missingInBank != rhs.missingInBank)
+            {
+                oss << "missingInBank: " << lhs.missingInBank.size() << " vs "
+                    << rhs.missingInBank.size() << " entries";
+                return oss.str();
+            }
+            return oss.str();
+        }
+    } // namespace
 
     /**
  * - match passed entries in both bank and book,
  * - push matches to results.matches
  * - push bank entries not found in books to results.missingInBooks
  * - push books entries not found in bank to results.missingInBank
+ *
+ * books entries are bucketed once by MatchEngine, and each bank entry takes the
+ * earliest unmatched books entry from its bucket; expected linear time. with a
+ * date tolerance, bank entries left over then take the nearest-dated books entry
+ * left over through DateWindowEngine.
  * */
-    void runReconciliation(passedAndFailedVecs& bank, entry_vec_sz_t bankBegin,
-                           passedAndFailedVecs& book, entry_vec_sz_t booksBegin,
-                           results_t& results)
+    void runReconciliation(const passedAndFailedVecs& bank, entry_vec_sz_t bankBegin,
+                           const passedAndFailedVecs& book, entry_vec_sz_t booksBegin,
+                           results_t& results, const ReconcileSettings& settings,
+                           Progress* progress)
+    {
+        /* the reference run starts from whatever results held on entry */
+        results_t reference;
+        if (settings.crossCheck)
+        {
+            reference = results;
+        }
+
+        sizeMatchedBitmaps(bank, book, results);
+        if (bank.passed && book.passed && !bank.passed->empty())
+        {
+            results.matches.reserve(bank.passed->size() + book.passed->size());
+            matchRows(bank.passed, rowsFrom(*bank.passed, bankBegin), book.passed,
+                      rowsFrom(*book.passed, booksBegin), results, settings, progress);
+        }
+        collectMissingInBank(bank, book, results);
+        markMissing(results);
+
+        if (settings.crossCheck)
+        {
+            runReconciliationNestedLoop(bank, bankBegin, book, booksBegin, reference,
+                                        settings);
+            const str diff = diffResults(results, reference);
+            if (!diff.empty())
+            {
+                throw ReconciliationMismatchError("hash-join differs from nested loop; " +
+                                                  diff);
+            }
+        }
+    }
+
+    void reconcileAppended(const passedAndFailedVecs& bank, entry_vec_sz_t bankFrom,
+                           const passedAndFailedVecs& book, entry_vec_sz_t booksFrom,
+                           results_t& results, const ReconcileSettings& settings,
+                           Progress* progress)
+    {
+        sizeMatchedBitmaps(bank, book, results);
+        if (!bank.passed || !book.passed)
+        {
+            return;
+        }
+        applyAppended(results, matchAppended(bank, bankFrom, book, booksFrom, results,
+                                             settings, progress));
+    }
+
+    AppendedMatches matchAppended(const passedAndFailedVecs& bank, entry_vec_sz_t bankFrom,
+                                  const passedAndFailedVecs& book, entry_vec_sz_t booksFrom,
+                                  const results_t& results, const ReconcileSettings& settings,
+                                  Progress* progress)
+    {
+        AppendedMatches appended;
+        appended.bankRows = bank.passed->size();
+        appended.booksRows = book.passed->size();
+
+        /* what is still missing on either side, then the new rows; all
+         * ascending. stale lists are read through the bits, as syncMissing
+         * would leave them */
+        auto stillMissing = [&results](const vec<entry_vec_sz_t>& missing,
+                                       const vec<bool>& bits) {
+            vec<entry_vec_sz_t> rows;
+            rows.reserve(missing.size());
+            for (const entry_vec_sz_t i : missing)
+            {
+                if (!results.missingStale || (i < bits.size() && bits[i]))
+                {
+                    rows.push_back(i);
+                }
+            }
+            return rows;
+        };
+        vec<entry_vec_sz_t> bankRows = stillMissing(results.missingInBook, results.bankMissing);
+        vec<entry_vec_sz_t> booksRows = stillMissing(results.missingInBank, results.booksMissing);
+        for (entry_vec_sz_t i = bankFrom; i < appended.bankRows; ++i)
+        {
+            bankRows.push_back(i);
+        }
+        for (entry_vec_sz_t i = booksFrom; i < appended.booksRows; ++i)
+        {
+            booksRows.push_back(i);
+        }
+
+        /* matchRows marks what it takes; only the bits of the rows above are
+         * read back */
+        results_t found;
+        found.bankMatched.resize(appended.bankRows, false);
+        found.booksMatched.resize(appended.booksRows, false);
+        matchRows(bank.passed, bankRows, book.passed, booksRows, found, settings, progress);
+        appended.matches = std::move(found.matches);
+        appended.missingInBook = std::move(found.missingInBook);
+        for (const entry_vec_sz_t i : booksRows)
+        {
+            if (!found.booksMatched[i])
+            {
+                appended.missingInBank.push_back(i);
+            }
+        }
+        return appended;
+    }
+
+    void applyAppended(results_t& results, AppendedMatches&& appended)
+    {
+        auto grow = [](vec<bool>& bits, entry_vec_sz_t rows) {
+            if (bits.size() < rows)
+            {
+                bits.resize(rows, false);
+            }
+        };
+        grow(results.bankMatched, appended.bankRows);
+        grow(results.booksMatched, appended.booksRows);
+        grow(results.bankMissing, appended.bankRows);
+        grow(results.booksMissing, appended.booksRows);
+
+        /* a matched row was either new or missing before; the rows missing now
+         * are all in the new lists */
+        for (const EntryMatch& m : appended.matches)
+        {
+            for (const EntryPointer& p : m.data())
+            {
+                const bool isBank = p.entryFor == EntryPointer::For::Bank;
+                (isBank ? results.bankMatched : results.booksMatched)[p.entryIdx] = true;
+                (isBank ? results.bankMissing : results.booksMissing)[p.entryIdx] = false;
+            }
+        }
+        for (const entry_vec_sz_t i : appended.missingInBook)
+        {
+            results.bankMissing[i] = true;
+        }
+        for (const entry_vec_sz_t i : appended.missingInBank)
+        {
+            results.booksMissing[i] = true;
+        }
+        results.matches.insert(results.matches.end(),
+                               std::make_move_iterator(appended.matches.begin()),
+                               std::make_move_iterator(appended.matches.end()));
+        results.missingInBook = std::move(appended.missingInBook);
+        results.missingInBank = std::move(appended.missingInBank);
+        results.missingStale = false;
+    }
+
+    void runReconciliationNestedLoop(const passedAndFailedVecs& bank,
+                                     entry_vec_sz_t bankBegin,
+                                     const passedAndFailedVecs& book,
+                                     entry_vec_sz_t booksBegin, results_t& results,
+                                     const ReconcileSettings& settings)
     {
 
+        sizeMatchedBitmaps(bank, book, results);
         if (bank.passed && book.passed && !bank.passed->empty())
         {
-            sp<entry_vec> bankPassedVec(bank.passed);
-            sp<entry_vec> booksPassedVec(book.passed);
+            sp<EntryStore> bankPassedVec(bank.passed);
+            sp<EntryStore> booksPassedVec(book.passed);
+            const EntryStore& bankEntries = *bank.passed;
+            const EntryStore& booksEntries = *book.passed;
             std::set<entry_vec_sz_t>
               skipBooksIds{}; // set to skip book_ids that have already been found.
 
             results.matches.reserve(bank.passed->size() + book.passed->size());
+            const vec<EntryMatch>::size_type matchesFrom = results.matches.size();
+            const vec<entry_vec_sz_t>::size_type missingFrom = results.missingInBook.size();
 
             for (entry_vec_sz_t bankIdx = bankBegin, bank_sz = bank.passed->size();
                  bankIdx != bank_sz; ++bankIdx)
@@ -72,9 +444,9 @@ namespace brlib
                         continue;
                     }
 
-                    const EntryBase& bankObj = bank.passed->at(bankIdx);
-                    const EntryBase& booksObj = book.passed->at(bookIdx);
-                    if (bankObj == booksObj)
+                    if (bankEntries.day(bankIdx) == booksEntries.day(bookIdx) &&
+                        bankEntries.debit(bankIdx) == booksEntries.debit(bookIdx) &&
+                        bankEntries.credit(bankIdx) == booksEntries.credit(bookIdx))
                     {
                         /* earlier we were constructing an EntryMatch with an idx of one books
            * entry and an idx of one bank entry. Now, we're constructing an
@@ -86,6 +458,9 @@ namespace brlib
                         m.insertIntoBooks(bookIdx, results);
                         results.matches.push_back(m);
                         skipBooksIds.insert(bookIdx);
+                        results.bankMatched[bankIdx] = true;
+                        results.booksMatched[bookIdx] = true;
+                        match_found = true;
                         break; // break inner book vector loop
                     }
                 }
@@ -94,162 +469,248 @@ namespace brlib
                     results.missingInBook.push_back(bankIdx);
                 }
             }
-        }
-        if (book.passed && bank.passed && !book.passed->empty())
-        {
-            entry_vec_sz_t booksIdx = 0, booksEnd = book.passed->size();
-            auto isBooksMatch = [&booksIdx](EntryMatch& m) {
-                return m.booksIdxExists(booksIdx);
-            };
-            for (; booksIdx != booksEnd; ++booksIdx)
+
+            if (hasDateTolerance(settings))
             {
-                bool skip_book =
-                  std::find_if(results.matches.begin(), results.matches.end(),
-                               isBooksMatch) != results.matches.end();
-                if (!skip_book)
+                /* leftovers take the nearest-dated books entry left over, then
+                 * this run's matches go back into bank order */
+                const vec<entry_vec_sz_t> leftover(
+                  results.missingInBook.begin() + std::ptrdiff_t(missingFrom),
+                  results.missingInBook.end());
+                results.missingInBook.resize(missingFrom);
+                for (const entry_vec_sz_t bankIdx : leftover)
                 {
-                    results.missingInBank.push_back(booksIdx);
+                    const day_t day = bankEntries.day(bankIdx);
+                    entry_vec_sz_t best = MatchEngine::npos;
+                    day_t bestDelta = 0;
+                    for (entry_vec_sz_t bookIdx = booksBegin, book_sz = book.passed->size();
+                         bookIdx != book_sz; ++bookIdx)
+                    {
+                        const day_t delta = booksEntries.day(bookIdx) - day;
+                        if (results.booksMatched[bookIdx] ||
+                            bankEntries.debit(bankIdx) != booksEntries.debit(bookIdx) ||
+                            bankEntries.credit(bankIdx) != booksEntries.credit(bookIdx) ||
+                            delta < -settings.booksDaysEarly || delta > settings.booksDaysLate)
+                        {
+                            continue;
+                        }
+                        if (best == MatchEngine::npos ||
+                            std::make_pair(std::abs(delta), delta) <
+                              std::make_pair(std::abs(bestDelta), bestDelta))
+                        {
+                            best = bookIdx;
+                            bestDelta = delta;
+                        }
+                    }
+                    if (best == MatchEngine::npos)
+                    {
+                        results.missingInBook.push_back(bankIdx);
+                        continue;
+                    }
+                    EntryMatch m({}, bankPassedVec, booksPassedVec);
+                    m.insertIntoBank(bankIdx, results);
+                    m.insertIntoBooks(best, results);
+                    results.matches.push_back(m);
+                    results.bankMatched[bankIdx] = true;
+                    results.booksMatched[best] = true;
                 }
+                std::stable_sort(results.matches.begin() + std::ptrdiff_t(matchesFrom),
+                                 results.matches.end(),
+                                 [](const EntryMatch& lhs, const EntryMatch& rhs) {
+                                     return lhs.data().front().entryIdx <
+                                            rhs.data().front().entryIdx;
+                                 });
             }
         }
+        collectMissingInBank(bank, book, results);
+        markMissing(results);
     }
 
-    void printPossibleRelns(const vec<PossibleRelation>& relns,
-                            sp_vec_entry_t& bank, sp_vec_entry_t& books)
+    void findRelatedRecords(const results_t& results, const sp_vec_entry_t& bank,
+                            const sp_vec_entry_t& books, vec<EntryMatch>& candidates,
+                            const RelatedSearchSettings& settings)
     {
-        std::cout << "------- relns -------" << std::endl;
-        for (const PossibleRelation& rel : relns)
+        if (bank->empty() || books->empty())
+        {
+            return;
+        }
+        const RelatedSearch search(*bank, *books, results, settings);
+        vec<EntryPointer> parents;
+        parents.reserve(results.missingInBook.size() + results.missingInBank.size());
+        for (const entry_vec_sz_t i : results.missingInBook)
         {
-            const EntryBase& par = bank->at(rel.parent);
-            const long& trxAmt = !par.debit ? par.credit : par.debit;
-            std::cout << "\tparent: " << trxAmt << std::endl;
-            for (const entry_vec_sz_t& c : rel.children)
+            if (RelatedSearch::isMissing(results.bankMissing, i))
             {
-                const EntryBase& ch = books->at(c);
-                const long& amt = &trxAmt == &par.debit ? ch.debit : ch.credit;
-                std::cout << "\t\tchild: " << amt << std::endl;
+                parents.emplace_back(i, EntryPointer::For::Bank);
+            }
+        }
+        for (const entry_vec_sz_t i : results.missingInBank)
+        {
+            if (RelatedSearch::isMissing(results.booksMissing, i))
+            {
+                parents.emplace_back(i, EntryPointer::For::Books);
             }
         }
-        std::cout << "--------------------" << std::endl;
-    }
 
-    void findRelatedRecords(results_t& results, sp_vec_entry_t& bank,
-                            sp_vec_entry_t& books, vec<PossibleRelation>& relns)
-    {
-        auto isTrxDirSame = [&](const EntryBase& lhs, const EntryBase& rhs) {
-            if (!lhs.credit)
+        /* each parent's search only reads the stores, and writes its own slot */
+        vec<std::optional<RelatedSearch::Group>> found(parents.size());
+        ThreadPool::shared().parallelFor(
+          parents.size(), settings.threads, [&](std::size_t i) {
+              found[i] = search.search(parents[i].entryFor, parents[i].entryIdx);
+          });
+        vec<RelatedSearch::Group> groups;
+        for (std::optional<RelatedSearch::Group>& g : found)
+        {
+            if (g)
             {
-                return rhs.credit == 0;
+                groups.push_back(std::move(*g));
             }
-            else
+        }
+
+        for (const RelatedSearch::Group& g : search.resolve(std::move(groups)))
+        {
+            const EntryPointer::For childFor = g.parentFor == EntryPointer::For::Bank ?
+                                                 EntryPointer::For::Books :
+                                                 EntryPointer::For::Bank;
+            vec<EntryPointer> data;
+            data.reserve(g.children.size() + 1);
+            data.emplace_back(g.parent, g.parentFor);
+            for (const entry_vec_sz_t c : g.children)
             {
-                return rhs.debit == 0;
+                data.emplace_back(c, childFor);
             }
-        };
+            candidates.emplace_back(std::move(data), bank, books, true);
+        }
+    }
 
-        auto isInDaysDelta = [&](const std::time_t& future, EntryBase& e) {
-            std::tm checkDate = e.date;
-            std::time_t checkTm = std::mktime(&checkDate);
-            return checkTm <= future;
-        };
+    /* LSD radix sort of day offsets from the earliest day, 11 bits a pass; a
+     * year of dates takes one pass. each pass is stable, so rows of one date
+     * stay in file order without the row being part of the key. */
+    vec<entry_vec_sz_t> sortedOrder(const EntryStore& entries)
+    {
+        const std::span<const day_t> days = entries.days();
+        vec<entry_vec_sz_t> order(days.size());
+        std::iota(order.begin(), order.end(), 0);
+        /* statements are nearly always in date order already */
+        if (std::is_sorted(days.begin(), days.end()))
+        {
+            return order;
+        }
 
-        const unsigned daysDelta = 5;
-        const long diffdelta = 60 * 60 * 24 * daysDelta;
-        vec<entry_vec_sz_t>& missingInBook = results.missingInBook;
-        vec<entry_vec_sz_t>& missingInBank = results.missingInBank;
-        if (!missingInBook.empty() && !bank->empty())
-        {
-            for (entry_vec_sz_t& currIdx : missingInBook)
-            {
-                EntryBase& currEntry = bank->at(currIdx);
-                std::tm currDate = currEntry.date;
-                // check for possible failure of mktime
-                std::time_t future = std::mktime(&currDate) + diffdelta;
-                long& trxAmt = !currEntry.debit ? currEntry.credit : currEntry.debit;
-                std::set<entry_vec_sz_t> perfectMatches;
-                PossibleRelation reln{currIdx, {}, false};
-                for (entry_vec_sz_t& checkIdx : missingInBank)
-                {
-                    EntryBase& checkEntry = books->at(checkIdx);
-                    /* now we're in allowed date range. */
-                    long& checkAmt =
-                      &trxAmt == &currEntry.debit ? checkEntry.debit : checkEntry.credit;
-                    if (!perfectMatches.contains(checkIdx) &&
-                        isTrxDirSame(currEntry, checkEntry) &&
-                        isInDaysDelta(future, checkEntry) && checkAmt <= trxAmt)
-                    {
-                        if (checkAmt == trxAmt)
-                        {
-                            reln.isExact = true;
-                            if (!reln.children.empty())
-                            {
-                                reln.children.clear();
-                            }
-                            reln.children.insert(checkIdx);
-                            perfectMatches.insert(checkIdx);
-                            break;
-                        }
-                        else
-                        {
-                            reln.children.insert(checkIdx);
-                        }
-                    }
-                }
-                relns.push_back(reln);
-                break;
+        const auto [minIt, maxIt] = std::minmax_element(days.begin(), days.end());
+        const day_t minDay = *minIt;
+        const std::uint32_t range = std::uint32_t(*maxIt) - std::uint32_t(minDay);
+        constexpr unsigned digitBits = 11;
+        constexpr std::uint32_t digitMask = (1u << digitBits) - 1;
+
+        vec<std::uint32_t> keys(days.size()), nextKeys(days.size());
+        for (entry_vec_sz_t i = 0; i < days.size(); ++i)
+        {
+            keys[i] = std::uint32_t(days[i]) - std::uint32_t(minDay);
+        }
+        vec<entry_vec_sz_t> nextOrder(days.size());
+        vec<std::size_t> counts(digitMask + 2);
+        for (unsigned shift = 0; shift < 32 && (range >> shift); shift += digitBits)
+        {
+            std::fill(counts.begin(), counts.end(), 0);
+            for (const std::uint32_t key : keys)
+            {
+                ++counts[((key >> shift) & digitMask) + 1];
             }
+            std::partial_sum(counts.begin(), counts.end(), counts.begin());
+            for (entry_vec_sz_t i = 0; i < keys.size(); ++i)
+            {
+                const std::size_t at = counts[(keys[i] >> shift) & digitMask]++;
+                nextKeys[at] = keys[i];
+                nextOrder[at] = order[i];
+            }
+            keys.swap(nextKeys);
+            order.swap(nextOrder);
         }
-        printPossibleRelns(relns, bank, books);
+        return order;
     }
-    void sortEntries(entry_vec& entries)
+
+    void sortEntries(EntryStore& entries)
     {
-        std::sort(entries.begin(), entries.end(),
-                  [&](const EntryBase& lhs, const EntryBase& rhs) {
-                      const std::tm& lDt = lhs.date;
-                      const std::tm& rDt = rhs.date;
-                      return lDt.tm_mday < rDt.tm_mday && lDt.tm_mon < rDt.tm_mon &&
-                             lDt.tm_year < rDt.tm_year;
-                  });
+        const vec<entry_vec_sz_t> order = sortedOrder(entries);
+        for (entry_vec_sz_t i = 0; i < order.size(); ++i)
+        {
+            if (order[i] != i)
+            {
+                entries.permute(order);
+                return;
+            }
+        }
     }
 
     /** match isn't const because we're clearing it after pushing a copy to vector.
  */
-    void saveManualMatch(results_t& results, EntryMatch& match)
+    ManualMatchChange saveManualMatch(results_t& results, EntryMatch& match)
     {
-        vec<entry_vec_sz_t>& missingInBank = results.missingInBank;
-        vec<entry_vec_sz_t>& missingInBooks = results.missingInBook;
+        ManualMatchChange change;
         if (match.isValid())
         {
-            for (const entry_vec_sz_t& bankIdx : match.banksIndices())
+            for (const EntryPointer& ep : match.data())
             {
-                auto it =
-                  std::find(missingInBooks.begin(), missingInBooks.end(), bankIdx);
-                if (it != missingInBooks.end())
+                const bool isBank = ep.entryFor == EntryPointer::For::Bank;
+                vec<bool>& matched = isBank ? results.bankMatched : results.booksMatched;
+                vec<bool>& missing = isBank ? results.bankMissing : results.booksMissing;
+                if (matched.size() <= ep.entryIdx)
                 {
-                    missingInBooks.erase(it);
+                    matched.resize(ep.entryIdx + 1, false);
                 }
-                else
-                {
-                    std::cerr
-                      << "saveManualMatch() missingInBooks bankIdx not found for erase.";
-                }
-            }
-            for (const entry_vec_sz_t& booksIdx : match.booksSet())
-            {
-                auto it = std::find(missingInBank.begin(), missingInBank.end(), booksIdx);
-                if (it != missingInBank.end())
+                matched[ep.entryIdx] = true;
+
+                if (ep.entryIdx < missing.size() && missing[ep.entryIdx])
                 {
-                    missingInBank.erase(it);
+                    missing[ep.entryIdx] = false;
+                    results.missingStale = true;
+                    (isBank ? change.bankRows : change.booksRows).push_back(ep.entryIdx);
                 }
                 else
                 {
-                    std::cerr
-                      << "saveManualMatch() missingInBank booksIdx not found for erase.";
+                    std::cerr << (isBank ? "saveManualMatch() bankIdx not missing in books." :
+                                           "saveManualMatch() booksIdx not missing in bank.");
                 }
             }
+            change.addedMatch = results.matches.size();
             results.matches.push_back(match);
         }
         match.clear();
+        return change;
+    }
+
+    void markMissing(results_t& results)
+    {
+        results.bankMissing.assign(results.bankMatched.size(), false);
+        results.booksMissing.assign(results.booksMatched.size(), false);
+        auto mark = [](vec<bool>& bits, const vec<entry_vec_sz_t>& missing) {
+            for (const entry_vec_sz_t i : missing)
+            {
+                if (bits.size() <= i)
+                {
+                    bits.resize(i + 1, false);
+                }
+                bits[i] = true;
+            }
+        };
+        mark(results.bankMissing, results.missingInBook);
+        mark(results.booksMissing, results.missingInBank);
+        results.missingStale = false;
+    }
+
+    void syncMissing(results_t& results)
+    {
+        if (!results.missingStale)
+        {
+            return;
+        }
+        auto cleared = [](const vec<bool>& bits) {
+            return [&bits](entry_vec_sz_t i) { return i >= bits.size() || !bits[i]; };
+        };
+        std::erase_if(results.missingInBook, cleared(results.bankMissing));
+        std::erase_if(results.missingInBank, cleared(results.booksMissing));
+        results.missingStale = false;
     }
 
 } // namespace brlib
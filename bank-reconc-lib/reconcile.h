@@ -1,9 +1,10 @@
 #ifndef BRLIB_RECONCILE_H
 #define BRLIB_RECONCILE_H
 
-#include <set>
+#include <optional>
 
 #include "EntryBase.h"
+#include "EntryStore.h"
 #include "brlib_common.h"
 #include "parse.h"
 
@@ -12,30 +13,104 @@ namespace brlib
 
     using namespace parse;
 
-    pr_vec_t findLastMatchingBalance(passedAndFailedVecs& lhs,
-                                     passedAndFailedVecs& rhs);
+    pr_vec_t findLastMatchingBalance(const passedAndFailedVecs& lhs,
+                                     const passedAndFailedVecs& rhs,
+                                     unsigned confirmRows = 0);
 
-    void runReconciliation(passedAndFailedVecs& bank, entry_vec_sz_t bankBegin,
-                           passedAndFailedVecs& book, entry_vec_sz_t booksBegin,
-                           results_t& results);
+    class ReconciliationMismatchError : public std::runtime_error
+    {
+    public:
+        explicit ReconciliationMismatchError(const str& s):
+            std::runtime_error(s) {}
+    };
+
+    /* with progress, matched bank rows are counted as they go, and a cancel
+     * throws Cancelled, leaving results part-filled */
+    void runReconciliation(const passedAndFailedVecs& bank, entry_vec_sz_t bankBegin,
+                           const passedAndFailedVecs& book, entry_vec_sz_t booksBegin,
+                           results_t& results,
+                           const ReconcileSettings& settings = {},
+                           Progress* progress = nullptr);
 
-    struct PossibleRelation
+    /** match rows appended to bank from bankFrom and to book from booksFrom,
+     * after a runReconciliation over the rows before them. new rows are matched
+     * against each other and against what results still has missing; existing
+     * matches, automatic or manual, stay as they are. costs about the number of
+     * new and missing rows, not the statement length. crossCheck is ignored.
+     * progress as for runReconciliation. */
+    void reconcileAppended(const passedAndFailedVecs& bank, entry_vec_sz_t bankFrom,
+                           const passedAndFailedVecs& book, entry_vec_sz_t booksFrom,
+                           results_t& results, const ReconcileSettings& settings = {},
+                           Progress* progress = nullptr);
+
+    /* what reconcileAppended adds to results */
+    struct AppendedMatches
     {
-        entry_vec_sz_t parent;
-        std::set<entry_vec_sz_t> children;
-        bool isExact;
+        /* new matches, in bank order */
+        vec<EntryMatch> matches;
+        /* the missing lists as they'll be: what stays missing of the old ones,
+         * then the new rows left unmatched */
+        vec<entry_vec_sz_t> missingInBook, missingInBank;
+        /* passed rows on either side when matched */
+        entry_vec_sz_t bankRows{0}, booksRows{0};
     };
-    void findRelatedRecords(results_t& results, sp_vec_entry_t& bank,
-                            sp_vec_entry_t& books, vec<PossibleRelation>& relns);
 
-    void printPossibleRelns(const vec<PossibleRelation>& relns,
-                            sp_vec_entry_t& bank, sp_vec_entry_t& books);
+    /** reconcileAppended in two steps. matchAppended only reads the stores and
+     * results, so they can be shown while it runs; applyAppended puts what it
+     * found into results, in the time of the new matches and missing rows. */
+    AppendedMatches matchAppended(const passedAndFailedVecs& bank, entry_vec_sz_t bankFrom,
+                                  const passedAndFailedVecs& book, entry_vec_sz_t booksFrom,
+                                  const results_t& results,
+                                  const ReconcileSettings& settings = {},
+                                  Progress* progress = nullptr);
+    void applyAppended(results_t& results, AppendedMatches&& appended);
+
+    /* the original O(n*m) matcher; kept as the reference for crossCheck. only
+     * the date tolerance of settings is used. */
+    void runReconciliationNestedLoop(const passedAndFailedVecs& bank,
+                                     entry_vec_sz_t bankBegin,
+                                     const passedAndFailedVecs& book,
+                                     entry_vec_sz_t booksBegin, results_t& results,
+                                     const ReconcileSettings& settings = {});
+
+    /** propose exact one-to-many matches among the entries left unmatched: a
+     * bank entry paid out as several books entries, or several bank entries
+     * booked as one. each entry is in at most one proposal. proposals are
+     * manual EntryMatches, accepted through saveManualMatch. entries are
+     * searched in parallel; where groups overlap the better scoring one is
+     * kept, so the proposals are the same for any thread count. */
+    void findRelatedRecords(const results_t& results, const sp_vec_entry_t& bank,
+                            const sp_vec_entry_t& books, vec<EntryMatch>& candidates,
+                            const RelatedSearchSettings& settings = {});
 
-    void sortEntries(entry_vec& entries);
+    /* row order that sorts entries by date, rows of one date kept in file order */
+    vec<entry_vec_sz_t> sortedOrder(const EntryStore& entries);
+
+    /* entries permuted into sortedOrder; untouched if already in it */
+    void sortEntries(EntryStore& entries);
 
     void sortMatches(vec<EntryMatch>& matches);
 
-    void saveManualMatch(results_t& results, EntryMatch& match);
+    /* what a saveManualMatch changed, so views can follow it row by row */
+    struct ManualMatchChange
+    {
+        /* entries no longer missing: bank ones of missingInBook, books ones of
+         * missingInBank */
+        vec<entry_vec_sz_t> bankRows, booksRows;
+        /* index of the match appended to results.matches, if it was valid */
+        std::optional<std::size_t> addedMatch;
+    };
+
+    /* clears the match's entries from the missing bits and marks them matched,
+     * O(1) per entry; the missing lists are left for syncMissing. */
+    ManualMatchChange saveManualMatch(results_t& results, EntryMatch& match);
+
+    /* set the missing bits from the missing lists, one per passed entry */
+    void markMissing(results_t& results);
+
+    /* drop entries whose missing bit was cleared from the missing lists,
+     * keeping their order; one pass over each list, and only if any were. */
+    void syncMissing(results_t& results);
 
 } // namespace brlib
 
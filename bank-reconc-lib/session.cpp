@@ -0,0 +1,524 @@
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <type_traits>
+
+#include "EntryMatch.h"
+#include "MappedFile.h"
+#include "RelatedSearch.h"
+#include "reconcile.h"
+#include "session.h"
+
+namespace brlib
+{
+
+    namespace
+    {
+        constexpr char snapshotMagic[8] = {'B', 'R', 'S', 'E', 'S', 'S', 'N', '\0'};
+        /* bump on any change to the layout below */
+        constexpr std::uint32_t snapshotVersion = 1;
+        constexpr std::uint32_t byteOrderMark = 0x01020304;
+        constexpr std::size_t sectionAlign = 64;
+
+        /* the columns of one side, bank then books */
+        enum SideSection : unsigned
+        {
+            Days,
+            Debits,
+            Credits,
+            Balances,
+            NarrEnds,
+            NarrArena,
+            FailedEnds,
+            FailedArena,
+            SideSectionCount
+        };
+
+        enum Section : unsigned
+        {
+            Meta,
+            Paths,
+            BankFirst,
+            BooksFirst = BankFirst + SideSectionCount,
+            /* end of each match's pointers in MatchPointers */
+            MatchEnds = BooksFirst + SideSectionCount,
+            /* entryIdx * 2, + 1 for a books entry */
+            MatchPointers,
+            MatchManual,
+            MissingInBook,
+            MissingInBank,
+            SectionCount
+        };
+
+        struct SectionRef
+        {
+            std::uint64_t offset;
+            std::uint64_t bytes;
+        };
+
+        struct Header
+        {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byteOrder;
+            std::uint8_t paiseBytes, sizeBytes, dayBytes, reserved;
+            std::uint32_t sectionCount;
+            SectionRef sections[SectionCount];
+        };
+
+        struct SideMeta
+        {
+            std::int32_t headerAt;
+            char dateSep;
+            std::uint8_t yearDigits;
+            char delimChar;
+            std::uint8_t singleAmountCol;
+            std::uint16_t numCols, firstRowAt;
+            std::int32_t colIndices[ManualParseSettings::TransactionType + 1];
+            std::uint64_t prefixBytes, lastLineBegin, lastLineHash;
+            std::uint64_t reconciledRows;
+        };
+
+        struct SessionMeta
+        {
+            SideMeta bank, books;
+            std::uint64_t bankPathBytes;
+            std::uint64_t minChunkBytes;
+            std::uint32_t threads;
+            std::uint8_t autoParse, reconciled;
+        };
+
+        static_assert(std::is_trivially_copyable_v<Header> &&
+                      std::is_trivially_copyable_v<SessionMeta>);
+
+        SideMeta sideMeta(const ManualParseSettings& options, const parse::ParsedPrefix& prefix,
+                          entry_vec_sz_t reconciledRows)
+        {
+            SideMeta meta{};
+            meta.headerAt = options.headerAt;
+            meta.dateSep = options.dateFormat.sep;
+            meta.yearDigits = std::uint8_t(options.dateFormat.yearDigits);
+            meta.delimChar = options.delimChar;
+            meta.singleAmountCol = options.singleAmountCol;
+            meta.numCols = options.numCols;
+            meta.firstRowAt = options.firstRowAt;
+            for (std::int32_t& idx : meta.colIndices)
+            {
+                idx = -1;
+            }
+            for (const auto& [col, idx] : options.colIndices)
+            {
+                meta.colIndices[col] = idx;
+            }
+            meta.prefixBytes = prefix.bytes;
+            meta.lastLineBegin = prefix.lastLineBegin;
+            meta.lastLineHash = prefix.lastLineHash;
+            meta.reconciledRows = reconciledRows;
+            return meta;
+        }
+
+        void applyMeta(const SideMeta& meta, ManualParseSettings& options,
+                       parse::ParsedPrefix& prefix, entry_vec_sz_t& reconciledRows)
+        {
+            const DateFormat* format = nullptr;
+            for (const DateFormat& f : dateFormats)
+            {
+                if (f.sep == meta.dateSep && f.yearDigits == meta.yearDigits)
+                {
+                    format = &f;
+                }
+            }
+            if (!format)
+            {
+                throw SessionFormatError("unknown date format in session");
+            }
+            options.headerAt = meta.headerAt;
+            options.dateFormat = *format;
+            options.delimChar = meta.delimChar;
+            options.singleAmountCol = meta.singleAmountCol != 0;
+            options.numCols = meta.numCols;
+            options.firstRowAt = meta.firstRowAt;
+            for (auto& [col, idx] : options.colIndices)
+            {
+                idx = meta.colIndices[col];
+            }
+            prefix = {meta.prefixBytes, meta.lastLineBegin, meta.lastLineHash};
+            reconciledRows = meta.reconciledRows;
+        }
+
+        /* failed rows as an arena and the end of each row in it */
+        struct Packed
+        {
+            vec<std::size_t> ends;
+            str arena;
+        };
+
+        Packed pack(const vec<str>& rows)
+        {
+            Packed packed;
+            packed.ends.reserve(rows.size());
+            for (const str& row : rows)
+            {
+                packed.arena += row;
+                packed.ends.push_back(packed.arena.size());
+            }
+            return packed;
+        }
+
+        class Reader
+        {
+        public:
+            explicit Reader(sp<const MappedFile> file):
+                m_file(std::move(file))
+            {
+                if (m_file->size() < sizeof(Header))
+                {
+                    throw SessionFormatError("not a session: too short");
+                }
+                std::memcpy(&m_header, m_file->data(), sizeof(Header));
+                if (std::memcmp(m_header.magic, snapshotMagic, sizeof(snapshotMagic)) != 0)
+                {
+                    throw SessionFormatError("not a session");
+                }
+                if (m_header.version != snapshotVersion ||
+                    m_header.sectionCount != SectionCount)
+                {
+                    throw SessionFormatError("session version " +
+                                             std::to_string(m_header.version) +
+                                             " isn't supported");
+                }
+                if (m_header.byteOrder != byteOrderMark ||
+                    m_header.paiseBytes != sizeof(paise_t) ||
+                    m_header.sizeBytes != sizeof(std::size_t) ||
+                    m_header.dayBytes != sizeof(day_t))
+                {
+                    throw SessionFormatError("session written on an incompatible machine");
+                }
+            }
+
+            template<typename T>
+            [[nodiscard]] std::span<const T> section(unsigned s) const
+            {
+                const SectionRef& ref = m_header.sections[s];
+                if (ref.offset > m_file->size() || ref.bytes > m_file->size() - ref.offset ||
+                    ref.offset % alignof(T) || ref.bytes % sizeof(T))
+                {
+                    throw SessionFormatError("session section " + std::to_string(s) +
+                                             " is out of bounds");
+                }
+                return {reinterpret_cast<const T*>(m_file->data() + ref.offset),
+                        ref.bytes / sizeof(T)};
+            }
+
+            [[nodiscard]] std::string_view text(unsigned s) const
+            {
+                const std::span<const char> chars = section<char>(s);
+                return {chars.data(), chars.size()};
+            }
+
+            [[nodiscard]] EntryStore store(EntryBase::EntryFrom from, unsigned first) const
+            {
+                const EntryStore::Columns columns{
+                  section<day_t>(first + Days), section<paise_t>(first + Debits),
+                  section<paise_t>(first + Credits), section<paise_t>(first + Balances),
+                  section<std::size_t>(first + NarrEnds), text(first + NarrArena)};
+                try
+                {
+                    return EntryStore(from, columns, m_file);
+                }
+                catch (const std::invalid_argument& e)
+                {
+                    throw SessionFormatError(str("session entries: ") + e.what());
+                }
+            }
+
+            [[nodiscard]] vec<str> failed(unsigned first) const
+            {
+                const std::span<const std::size_t> ends = section<std::size_t>(first + FailedEnds);
+                const std::string_view arena = text(first + FailedArena);
+                vec<str> rows;
+                rows.reserve(ends.size());
+                std::size_t begin = 0;
+                for (const std::size_t end : ends)
+                {
+                    if (end < begin || end > arena.size())
+                    {
+                        throw SessionFormatError("session failed rows run past their arena");
+                    }
+                    rows.emplace_back(arena.substr(begin, end - begin));
+                    begin = end;
+                }
+                return rows;
+            }
+
+        private:
+            sp<const MappedFile> m_file;
+            Header m_header{};
+        };
+
+        vec<entry_vec_sz_t> indices(std::span<const std::uint64_t> stored,
+                                    entry_vec_sz_t rows)
+        {
+            vec<entry_vec_sz_t> out(stored.begin(), stored.end());
+            for (const entry_vec_sz_t i : out)
+            {
+                if (i >= rows)
+                {
+                    throw SessionFormatError("session missing entry out of range");
+                }
+            }
+            return out;
+        }
+    } // namespace
+
+    void saveSession(const str& path, const Session& session)
+    {
+        const EntryStore& bank = *session.bank.passed;
+        const EntryStore& books = *session.books.passed;
+        const results_t& results = session.results;
+
+        SessionMeta meta{};
+        meta.bank = sideMeta(session.settings.bank, session.bank.prefix,
+                             session.bankReconciledRows);
+        meta.books = sideMeta(session.settings.books, session.books.prefix,
+                              session.booksReconciledRows);
+        meta.bankPathBytes = session.bankPath.size();
+        meta.minChunkBytes = session.settings.parallel.minChunkBytes;
+        meta.threads = session.settings.parallel.threads;
+        meta.autoParse = session.settings.isAutoParseEnabled();
+        meta.reconciled = session.reconciled;
+        const str paths = session.bankPath + session.booksPath;
+
+        const Packed bankFailed = pack(*session.bank.failed);
+        const Packed booksFailed = pack(*session.books.failed);
+
+        vec<std::uint64_t> matchEnds, matchPointers;
+        vec<std::uint8_t> matchManual;
+        matchEnds.reserve(results.matches.size());
+        matchManual.reserve(results.matches.size());
+        for (const EntryMatch& m : results.matches)
+        {
+            for (const EntryPointer& p : m.data())
+            {
+                matchPointers.push_back(std::uint64_t(p.entryIdx) * 2 +
+                                        (p.entryFor == EntryPointer::For::Books));
+            }
+            matchEnds.push_back(matchPointers.size());
+            matchManual.push_back(m.isManual());
+        }
+        /* only what is still missing; the lists may lag the bits, see syncMissing */
+        auto stillMissing = [](const vec<entry_vec_sz_t>& list, const vec<bool>& bits) {
+            vec<std::uint64_t> out;
+            out.reserve(list.size());
+            for (const entry_vec_sz_t i : list)
+            {
+                if (RelatedSearch::isMissing(bits, i))
+                {
+                    out.push_back(i);
+                }
+            }
+            return out;
+        };
+        const vec<std::uint64_t> missingInBook =
+          stillMissing(results.missingInBook, results.bankMissing);
+        const vec<std::uint64_t> missingInBank =
+          stillMissing(results.missingInBank, results.booksMissing);
+
+        std::array<std::span<const char>, SectionCount> sections;
+        auto bytesOf = [](const auto& range) {
+            return std::span<const char>(reinterpret_cast<const char*>(range.data()),
+                                         range.size() * sizeof(range[0]));
+        };
+        sections[Meta] = {reinterpret_cast<const char*>(&meta), sizeof(meta)};
+        sections[Paths] = bytesOf(paths);
+        auto side = [&](unsigned first, const EntryStore& store, const Packed& failed) {
+            const EntryStore::Columns& cols = store.columns();
+            sections[first + Days] = bytesOf(cols.days);
+            sections[first + Debits] = bytesOf(cols.debits);
+            sections[first + Credits] = bytesOf(cols.credits);
+            sections[first + Balances] = bytesOf(cols.balances);
+            sections[first + NarrEnds] = bytesOf(cols.narrEnds);
+            sections[first + NarrArena] = bytesOf(cols.narrArena);
+            sections[first + FailedEnds] = bytesOf(failed.ends);
+            sections[first + FailedArena] = bytesOf(failed.arena);
+        };
+        side(BankFirst, bank, bankFailed);
+        side(BooksFirst, books, booksFailed);
+        sections[MatchEnds] = bytesOf(matchEnds);
+        sections[MatchPointers] = bytesOf(matchPointers);
+        sections[MatchManual] = bytesOf(matchManual);
+        sections[MissingInBook] = bytesOf(missingInBook);
+        sections[MissingInBank] = bytesOf(missingInBank);
+
+        Header header{};
+        std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+        header.version = snapshotVersion;
+        header.byteOrder = byteOrderMark;
+        header.paiseBytes = sizeof(paise_t);
+        header.sizeBytes = sizeof(std::size_t);
+        header.dayBytes = sizeof(day_t);
+        header.sectionCount = SectionCount;
+        auto aligned = [](std::uint64_t n) {
+            return (n + sectionAlign - 1) / sectionAlign * sectionAlign;
+        };
+        std::uint64_t offset = aligned(sizeof(Header));
+        for (unsigned s = 0; s < SectionCount; ++s)
+        {
+            header.sections[s] = {offset, sections[s].size()};
+            offset = aligned(offset + sections[s].size());
+        }
+
+        const str tmpPath = path + ".tmp";
+        /* no error leaves the temporary file behind */
+        auto failed = [&tmpPath](const str& what) {
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return FileOpenError(what);
+        };
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                throw failed("couldn't write " + tmpPath);
+            }
+            const char padding[sectionAlign]{};
+            std::uint64_t written = 0;
+            auto put = [&](const char* data, std::uint64_t bytes) {
+                out.write(data, std::streamsize(bytes));
+                written += bytes;
+            };
+            put(reinterpret_cast<const char*>(&header), sizeof(header));
+            for (unsigned s = 0; s < SectionCount; ++s)
+            {
+                put(padding, header.sections[s].offset - written);
+                put(sections[s].data(), sections[s].size());
+            }
+            /* closed before any remove, which Windows refuses on open files */
+            out.close();
+            if (!out)
+            {
+                throw failed("couldn't write " + tmpPath);
+            }
+        }
+        /* on disk before it takes path's name, so a crash leaves the old
+         * snapshot or the whole new one */
+        if (!syncFile(tmpPath))
+        {
+            throw failed("couldn't sync " + tmpPath);
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec)
+        {
+            throw failed("couldn't replace " + path);
+        }
+        /* and the rename itself; best effort, see syncFile */
+        const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+        syncFile(dir.empty() ? str(".") : dir.string());
+    }
+
+    void openSession(const str& path, Session& session)
+    {
+        const Reader reader(std::make_shared<const MappedFile>(path));
+
+        const std::span<const char> metaBytes = reader.section<char>(Meta);
+        if (metaBytes.size() != sizeof(SessionMeta))
+        {
+            throw SessionFormatError("session settings have the wrong size");
+        }
+        SessionMeta meta;
+        std::memcpy(&meta, metaBytes.data(), sizeof(meta));
+
+        ParseSettings settings;
+        parse::ParsedPrefix bankPrefix, booksPrefix;
+        entry_vec_sz_t bankReconciledRows = 0, booksReconciledRows = 0;
+        applyMeta(meta.bank, settings.bank, bankPrefix, bankReconciledRows);
+        applyMeta(meta.books, settings.books, booksPrefix, booksReconciledRows);
+        settings.setAutoParse(meta.autoParse != 0);
+        settings.parallel.threads = meta.threads;
+        settings.parallel.minChunkBytes = meta.minChunkBytes;
+
+        const std::string_view paths = reader.text(Paths);
+        if (meta.bankPathBytes > paths.size())
+        {
+            throw SessionFormatError("session paths run past their section");
+        }
+
+        EntryStore bank = reader.store(EntryBase::EntryFrom::Bank, BankFirst);
+        EntryStore books = reader.store(EntryBase::EntryFrom::Books, BooksFirst);
+        vec<str> bankFailed = reader.failed(BankFirst);
+        vec<str> booksFailed = reader.failed(BooksFirst);
+
+        results_t results;
+        results.bankMatched.assign(bank.size(), false);
+        results.booksMatched.assign(books.size(), false);
+
+        const std::span<const std::uint64_t> ends = reader.section<std::uint64_t>(MatchEnds);
+        const std::span<const std::uint64_t> pointers =
+          reader.section<std::uint64_t>(MatchPointers);
+        const std::span<const std::uint8_t> manual = reader.section<std::uint8_t>(MatchManual);
+        if (manual.size() != ends.size())
+        {
+            throw SessionFormatError("session matches disagree on their count");
+        }
+        std::uint64_t begin = 0;
+        for (const std::uint64_t end : ends)
+        {
+            if (end < begin || end > pointers.size())
+            {
+                throw SessionFormatError("session match runs past its entries");
+            }
+            begin = end;
+        }
+        for (const std::uint64_t p : pointers.first(begin))
+        {
+            const entry_vec_sz_t idx = p / 2;
+            const bool isBooks = p % 2;
+            if (idx >= (isBooks ? books.size() : bank.size()))
+            {
+                throw SessionFormatError("session match entry out of range");
+            }
+            (isBooks ? results.booksMatched : results.bankMatched)[idx] = true;
+        }
+        results.missingInBook =
+          indices(reader.section<std::uint64_t>(MissingInBook), bank.size());
+        results.missingInBank =
+          indices(reader.section<std::uint64_t>(MissingInBank), books.size());
+
+        /* all read and checked; session is replaced from here on */
+        session.bankPath = paths.substr(0, meta.bankPathBytes);
+        session.booksPath = paths.substr(meta.bankPathBytes);
+        *session.bank.passed = std::move(bank);
+        *session.books.passed = std::move(books);
+        *session.bank.failed = std::move(bankFailed);
+        *session.books.failed = std::move(booksFailed);
+        session.bank.prefix = bankPrefix;
+        session.books.prefix = booksPrefix;
+
+        /* matches read their amounts from session's stores */
+        results.matches.reserve(ends.size());
+        begin = 0;
+        for (std::size_t m = 0; m < ends.size(); ++m)
+        {
+            vec<EntryPointer> data;
+            data.reserve(ends[m] - begin);
+            for (; begin < ends[m]; ++begin)
+            {
+                data.emplace_back(pointers[begin] / 2, pointers[begin] % 2 ?
+                                                         EntryPointer::For::Books :
+                                                         EntryPointer::For::Bank);
+            }
+            results.matches.emplace_back(std::move(data), session.bank.passed,
+                                         session.books.passed, manual[m] != 0);
+        }
+        session.results = std::move(results);
+        markMissing(session.results);
+        session.settings = settings;
+        session.reconciled = meta.reconciled != 0;
+        session.bankReconciledRows = bankReconciledRows;
+        session.booksReconciledRows = booksReconciledRows;
+    }
+
+} // namespace brlib
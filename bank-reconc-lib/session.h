@@ -0,0 +1,51 @@
+#ifndef BRLIB_SESSION_H
+#define BRLIB_SESSION_H
+
+#include "EntryStore.h"
+#include "brlib_common.h"
+#include "parse.h"
+
+namespace brlib
+{
+
+    class SessionFormatError : public std::runtime_error
+    {
+    public:
+        explicit SessionFormatError(const str& s):
+            std::runtime_error(s) {}
+    };
+
+    /* everything needed to pick a reconciliation up where it was left */
+    struct Session
+    {
+        str bankPath, booksPath;
+        parse::passedAndFailedVecs bank, books;
+        results_t results;
+        ParseSettings settings;
+        /* results cover the rows before these, see reconcileAppended */
+        bool reconciled{false};
+        entry_vec_sz_t bankReconciledRows{0}, booksReconciledRows{0};
+    };
+
+    /** write session to path as a snapshot: a header of section offsets, then
+     * the entry columns, matches and missing lists as flat arrays, each at a
+     * 64 byte boundary. numbers are stored as the writing machine holds them,
+     * so the header records byte order and type sizes and a snapshot only
+     * opens where they agree. written to a temporary file, flushed to disk
+     * and renamed over path, so a crash never leaves half a snapshot. throws
+     * FileOpenError, after removing the temporary file. */
+    void saveSession(const str& path, const Session& session);
+
+    /** map a snapshot written by saveSession into session. the entry stores
+     * read their columns straight from the mapping, which stays open until
+     * the stores are changed or cleared; only matches and the missing lists
+     * are rebuilt, from flat arrays. session's stores are filled in place, so
+     * whatever already holds them sees the snapshot's entries, and the
+     * matches point at them. the whole file is checked before session is
+     * touched; it's left as it was on FileOpenError, or on SessionFormatError
+     * if the file isn't a snapshot this build can read. */
+    void openSession(const str& path, Session& session);
+
+} // namespace brlib
+
+#endif // BRLIB_SESSION_H
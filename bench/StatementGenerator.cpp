@@ -0,0 +1,289 @@
+#include <cstdio>
+
+#include "StatementGenerator.h"
+
+namespace brbench
+{
+
+    namespace
+    {
+        /* splitmix64; std distributions differ between standard libraries */
+        class Rng
+        {
+        public:
+            explicit Rng(std::uint64_t seed):
+                m_state(seed) {}
+
+            std::uint64_t next()
+            {
+                std::uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                return z ^ (z >> 31);
+            }
+
+            /* uniform in [0, n) */
+            std::uint64_t below(std::uint64_t n) { return next() % n; }
+
+            bool chance(double rate) { return double(next() >> 11) * 0x1.0p-53 < rate; }
+
+        private:
+            std::uint64_t m_state;
+        };
+
+        const char* delimName(char delim)
+        {
+            switch (delim)
+            {
+                case '\t':
+                    return "tab";
+                case '|':
+                    return "pipe";
+                default:
+                    return "comma";
+            }
+        }
+
+        class Writer
+        {
+        public:
+            Writer(const Layout& layout, str& out):
+                m_layout(layout), m_out(out) {}
+
+            void header(const char* narrCol, bool bank)
+            {
+                m_out += bank ? "Statement of account\n" : "Ledger\n";
+                m_out += "Date";
+                field(narrCol);
+                if (bank)
+                {
+                    field("Chq No");
+                }
+                if (m_layout.singleAmountCol)
+                {
+                    field("Amount");
+                    field("Dr/Cr");
+                }
+                else
+                {
+                    field(bank ? "Withdrawal" : "Debit");
+                    field(bank ? "Deposit" : "Credit");
+                }
+                field("Balance");
+                m_out += '\n';
+            }
+
+            void date(brlib::day_t day)
+            {
+                const std::tm t = brlib::tmFromDays(day);
+                const int year = m_layout.dateFormat.yearDigits == 2 ? t.tm_year % 100 :
+                                                                       t.tm_year + 1900;
+                const char sep = m_layout.dateFormat.sep;
+                char buf[16];
+                const int len =
+                  std::snprintf(buf, sizeof(buf), "%02d%c%02d%c%0*d", t.tm_mday, sep,
+                                t.tm_mon + 1, sep, int(m_layout.dateFormat.yearDigits), year);
+                m_out.append(buf, len);
+            }
+
+            void field(std::string_view s)
+            {
+                m_out += m_layout.delim.value;
+                m_out += s;
+            }
+
+            /* narrations hold the comma of comma layouts, so they're quoted there */
+            void narr(std::string_view s)
+            {
+                m_out += m_layout.delim.value;
+                if (m_layout.delim.value == ',')
+                {
+                    m_out += '"';
+                    m_out += s;
+                    m_out += '"';
+                }
+                else
+                {
+                    m_out += s;
+                }
+            }
+
+            /* plain in comma layouts, Indian grouping elsewhere */
+            void amount(brlib::paise_t paise)
+            {
+                m_out += m_layout.delim.value;
+                if (paise < 0)
+                {
+                    m_out += '-';
+                    paise = -paise;
+                }
+                const str rupees = std::to_string(paise / 100);
+                if (m_layout.delim.value == ',' || rupees.size() <= 3)
+                {
+                    m_out += rupees;
+                }
+                else
+                {
+                    const std::size_t head = rupees.size() - 3;
+                    for (std::size_t i = 0; i < head; ++i)
+                    {
+                        m_out += rupees[i];
+                        if ((head - i) % 2 == 1 && i + 1 != head)
+                        {
+                            m_out += ',';
+                        }
+                    }
+                    m_out += ',';
+                    m_out.append(rupees, head, 3);
+                }
+                char frac[4];
+                std::snprintf(frac, sizeof(frac), ".%02d", int(paise % 100));
+                m_out += frac;
+            }
+
+            /* Debit / Credit columns, or Amount and a DR / CR flag */
+            void movement(bool isDebit, brlib::paise_t paise)
+            {
+                if (m_layout.singleAmountCol)
+                {
+                    amount(paise);
+                    field(isDebit ? "DR" : "CR");
+                }
+                else if (isDebit)
+                {
+                    amount(paise);
+                    field("");
+                }
+                else
+                {
+                    field("");
+                    amount(paise);
+                }
+            }
+
+            void end() { m_out += '\n'; }
+
+        private:
+            const Layout& m_layout;
+            str& m_out;
+        };
+    } // namespace
+
+    str Layout::name() const
+    {
+        str n = delimName(delim.value);
+        n += singleAmountCol ? "-amount-" : "-drcr-";
+        n += dateFormat.sep == '/' ? "slash-" : "dash-";
+        n += dateFormat.yearDigits == 2 ? "yy" : "yyyy";
+        return n;
+    }
+
+    vec<Layout> allLayouts()
+    {
+        vec<Layout> layouts;
+        for (const brlib::Delim& delim : brlib::delims)
+        {
+            for (const brlib::DateFormat& fmt : brlib::dateFormats)
+            {
+                for (const bool single : {false, true})
+                {
+                    layouts.push_back({delim, fmt, single});
+                }
+            }
+        }
+        return layouts;
+    }
+
+    GeneratedStatements generateStatements(const Layout& layout,
+                                           const GeneratorSettings& settings)
+    {
+        GeneratedStatements gen;
+        Rng rng(settings.seed);
+
+        /* ~80 bytes a row on each side */
+        gen.bank.reserve(settings.rows * 80 + 256);
+        gen.books.reserve(settings.rows * 90 + 256);
+        Writer bank(layout, gen.bank), books(layout, gen.books);
+        bank.header("Narration", true);
+        books.header("Particulars", false);
+
+        const brlib::day_t firstDay = brlib::daysFromCivil(2021, 4, 1);
+        /* opening balance of a crore, so neither side goes overdrawn */
+        brlib::paise_t bankBalance = 1000000000, booksBalance = bankBalance;
+
+        auto booksRow = [&](brlib::day_t day, std::string_view narr, bool isDebit,
+                            brlib::paise_t paise) {
+            booksBalance += isDebit ? paise : -paise;
+            books.date(day);
+            books.narr(narr);
+            books.movement(isDebit, paise);
+            books.amount(booksBalance < 0 ? -booksBalance : booksBalance);
+            gen.books.append(booksBalance < 0 ? " Cr" : " Dr");
+            books.end();
+            return gen.booksRows++;
+        };
+
+        char narr[64];
+        for (std::size_t i = 0; i < settings.rows; ++i)
+        {
+            /* spread over a year, a few rows a day */
+            const brlib::day_t day =
+              firstDay + brlib::day_t(i * 365 / std::max<std::size_t>(settings.rows, 1));
+            const bool deposit = rng.chance(0.4);
+            const brlib::paise_t paise = 100 + brlib::paise_t(rng.below(5000000));
+
+            bankBalance += deposit ? paise : -paise;
+            std::snprintf(narr, sizeof(narr), "UPI/%zu, ref %llu", i,
+                          static_cast<unsigned long long>(rng.below(1000000)));
+            bank.date(day);
+            bank.narr(narr);
+            bank.field(std::to_string(i));
+            /* a withdrawal is the bank's debit, and a credit in the books */
+            bank.movement(!deposit, paise);
+            bank.amount(bankBalance);
+            bank.end();
+            const std::size_t bankRow = gen.bankRows++;
+
+            /* books side of the same transaction */
+            const bool booksDebit = deposit;
+            if (rng.chance(settings.missingRate))
+            {
+                /* not booked yet */
+            }
+            else if (paise >= 300 && rng.chance(settings.splitRate))
+            {
+                SplitGroup group{bankRow, {}};
+                const long parts = 2 + long(rng.below(3));
+                brlib::paise_t left = paise;
+                for (long p = 0; p < parts; ++p)
+                {
+                    const brlib::paise_t part =
+                      p + 1 == parts ? left :
+                                       1 + brlib::paise_t(rng.below(left - (parts - p - 1))) /
+                                             (parts - p);
+                    left -= part;
+                    std::snprintf(narr, sizeof(narr), "Party %zu part %ld", i, p + 1);
+                    group.booksRows.push_back(booksRow(day, narr, booksDebit, part));
+                }
+                gen.splits.push_back(std::move(group));
+            }
+            else
+            {
+                const brlib::day_t booked =
+                  rng.chance(settings.dateShiftRate) ? day + 1 + brlib::day_t(rng.below(3)) :
+                                                       day;
+                std::snprintf(narr, sizeof(narr), "Party %zu", i);
+                booksRow(booked, narr, booksDebit, paise);
+            }
+
+            /* cheques issued but not presented yet */
+            if (rng.chance(settings.missingRate))
+            {
+                std::snprintf(narr, sizeof(narr), "Cheque %zu", i);
+                booksRow(day, narr, false, 100 + brlib::paise_t(rng.below(2000000)));
+            }
+        }
+        return gen;
+    }
+
+} // namespace brbench
@@ -0,0 +1,63 @@
+#ifndef BRBENCH_STATEMENTGENERATOR_H
+#define BRBENCH_STATEMENTGENERATOR_H
+
+#include <cstdint>
+
+#include <brlib_common.h>
+
+namespace brbench
+{
+
+    using brlib::str;
+    using brlib::vec;
+
+    /* how a generated pair of files is laid out */
+    struct Layout
+    {
+        brlib::Delim delim;
+        brlib::DateFormat dateFormat;
+        /* Amount + Dr/Cr columns instead of Debit / Credit */
+        bool singleAmountCol{false};
+
+        [[nodiscard]] str name() const;
+    };
+
+    /* every delim x date format x amount column combination */
+    vec<Layout> allLayouts();
+
+    struct GeneratorSettings
+    {
+        std::size_t rows{100000};
+        std::uint64_t seed{1};
+        /* share of bank rows left out of books, and of extra books-only rows */
+        double missingRate{0.02};
+        /* share of bank rows booked as 2-4 ledger entries summing to it */
+        double splitRate{0.01};
+        /* share of ledger entries booked 1-3 days after the bank date */
+        double dateShiftRate{0.01};
+    };
+
+    /* a bank row and the books rows it was split into; row numbers count data
+     * rows only, i.e. they are indices into the parsed passed entries. */
+    struct SplitGroup
+    {
+        std::size_t bankRow;
+        vec<std::size_t> booksRows;
+    };
+
+    struct GeneratedStatements
+    {
+        str bank, books;
+        std::size_t bankRows{0}, booksRows{0};
+        vec<SplitGroup> splits;
+    };
+
+    /** bank statement and matching ledger with the settings' rates of missing,
+     * split and late entries. the same settings and layout always give the
+     * same bytes, on any platform. */
+    GeneratedStatements generateStatements(const Layout& layout,
+                                           const GeneratorSettings& settings);
+
+} // namespace brbench
+
+#endif // BRBENCH_STATEMENTGENERATOR_H
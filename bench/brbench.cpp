@@ -0,0 +1,428 @@
+/* throughput of each library stage over generated statements, one row per
+ * layout and stage. also writes the generated files for use with brcli. */
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include <EntryMatch.h>
+#include <reconcile.h>
+#include <session.h>
+
+#include "StatementGenerator.h"
+
+namespace brbench
+{
+
+    class UsageError : public std::invalid_argument
+    {
+    public:
+        explicit UsageError(const str& s):
+            std::invalid_argument(s) {}
+    };
+
+    struct Options
+    {
+        GeneratorSettings gen;
+        /* substring of the layout names to run; empty runs all */
+        str layoutFilter;
+        unsigned reps{3};
+        brlib::ParallelParseSettings parallel;
+        /* write the generated files here instead of benchmarking */
+        str writeDir;
+    };
+
+    static const char usage[] =
+      "usage: brbench [options]\n"
+      "\n"
+      "  -n, --rows N          bank rows per statement (default 100000)\n"
+      "  -s, --seed N          generator seed (default 1)\n"
+      "      --missing R       share of missing entries (default 0.02)\n"
+      "      --split R         share of bank rows split in books (default 0.01)\n"
+      "      --shift R         share of ledger entries booked late (default 0.01)\n"
+      "  -l, --layout TEXT     only layouts whose name contains TEXT\n"
+      "  -r, --reps N          runs per stage; the fastest is reported (default 3)\n"
+      "  -j, --threads N       parse and search threads; 0 uses every core (default 0)\n"
+      "  -w, --write DIR       write <layout>-bank.txt / -books.txt to DIR and exit\n"
+      "  -h, --help\n";
+
+    template<typename T>
+    T toNumber(std::string_view s, const char* what)
+    {
+        T value{};
+        const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        if (ec != std::errc() || end != s.data() + s.size())
+        {
+            throw UsageError(str("bad ") + what + ": " + str(s));
+        }
+        return value;
+    }
+
+    double toRate(std::string_view s)
+    {
+        /* from_chars for double isn't in every standard library yet */
+        const str copy(s);
+        char* end = nullptr;
+        const double value = std::strtod(copy.c_str(), &end);
+        if (end != copy.c_str() + copy.size() || value < 0 || value > 1)
+        {
+            throw UsageError("bad rate: " + copy);
+        }
+        return value;
+    }
+
+    Options parseArgs(int argc, char** argv)
+    {
+        Options opts;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            auto value = [&]() -> std::string_view {
+                if (i + 1 >= argc)
+                {
+                    throw UsageError(str(arg) + " needs a value");
+                }
+                return argv[++i];
+            };
+            if (arg == "-h" || arg == "--help")
+            {
+                std::cout << usage;
+                std::exit(0);
+            }
+            else if (arg == "-n" || arg == "--rows")
+            {
+                opts.gen.rows = toNumber<std::size_t>(value(), "row count");
+            }
+            else if (arg == "-s" || arg == "--seed")
+            {
+                opts.gen.seed = toNumber<std::uint64_t>(value(), "seed");
+            }
+            else if (arg == "--missing")
+            {
+                opts.gen.missingRate = toRate(value());
+            }
+            else if (arg == "--split")
+            {
+                opts.gen.splitRate = toRate(value());
+            }
+            else if (arg == "--shift")
+            {
+                opts.gen.dateShiftRate = toRate(value());
+            }
+            else if (arg == "-l" || arg == "--layout")
+            {
+                opts.layoutFilter = value();
+            }
+            else if (arg == "-r" || arg == "--reps")
+            {
+                opts.reps = std::max(1u, toNumber<unsigned>(value(), "rep count"));
+            }
+            else if (arg == "-j" || arg == "--threads")
+            {
+                opts.parallel.threads = toNumber<unsigned>(value(), "thread count");
+            }
+            else if (arg == "-w" || arg == "--write")
+            {
+                opts.writeDir = value();
+            }
+            else
+            {
+                throw UsageError("unknown option: " + str(arg));
+            }
+        }
+        return opts;
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    /* fastest of reps runs of stage; setup runs untimed before each */
+    template<typename Setup, typename Stage>
+    double bestSeconds(unsigned reps, Setup&& setup, Stage&& stage)
+    {
+        double best = 0;
+        for (unsigned r = 0; r < reps; ++r)
+        {
+            setup();
+            const auto t0 = clock::now();
+            stage();
+            const double secs = std::chrono::duration<double>(clock::now() - t0).count();
+            best = r ? std::min(best, secs) : secs;
+        }
+        return best;
+    }
+
+    void report(const str& layout, const char* stage, std::size_t rows, std::size_t bytes,
+                double secs)
+    {
+        const double s = std::max(secs, 1e-9);
+        std::printf("%-24s %-12s %10zu %9.2f %10.3f %14.0f %10.1f\n", layout.c_str(), stage,
+                    rows, bytes / 1e6, secs * 1e3, rows / s, bytes ? bytes / 1e6 / s : 0.0);
+    }
+
+    void runLayout(const Layout& layout, const Options& opts)
+    {
+        const GeneratedStatements gen = generateStatements(layout, opts.gen);
+        const str name = layout.name();
+
+        brlib::ManualParseSettings bankSettings, booksSettings;
+        brlib::passedAndFailedVecs bank, books;
+        auto parse = [&](brlib::EntryBase::EntryFrom from, const str& data,
+                         brlib::passedAndFailedVecs& vecs,
+                         brlib::ManualParseSettings& settings) {
+            brlib::parseEntries(from, std::string_view(data), vecs, true, settings,
+                                opts.parallel);
+        };
+
+        const double bankSecs = bestSeconds(
+          opts.reps, [&]() { bank = {}; },
+          [&]() { parse(brlib::EntryBase::EntryFrom::Bank, gen.bank, bank, bankSettings); });
+        report(name, "parse-bank", bank.passed->size(), gen.bank.size(), bankSecs);
+
+        const double booksSecs = bestSeconds(
+          opts.reps, [&]() { books = {}; },
+          [&]() {
+              parse(brlib::EntryBase::EntryFrom::Books, gen.books, books, booksSettings);
+          });
+        report(name, "parse-books", books.passed->size(), gen.books.size(), booksSecs);
+
+        if (bank.passed->size() != gen.bankRows || books.passed->size() != gen.booksRows)
+        {
+            std::fprintf(stderr, "%s: parsed %zu / %zu rows of %zu / %zu generated\n",
+                         name.c_str(), bank.passed->size(), books.passed->size(),
+                         gen.bankRows, gen.booksRows);
+        }
+        const std::size_t bothRows = bank.passed->size() + books.passed->size();
+
+        const double balanceSecs = bestSeconds(
+          opts.reps, []() {},
+          [&]() { (void)brlib::findLastMatchingBalance(bank, books); });
+        report(name, "last-balance", bothRows, 0, balanceSecs);
+
+        brlib::results_t results;
+        const double matchSecs =
+          bestSeconds(opts.reps, [&]() { results = {}; },
+                      [&]() { brlib::runReconciliation(bank, 0, books, 0, results); });
+        report(name, "reconcile", bothRows, 0, matchSecs);
+
+        /* the last day's rows of each file arriving on top of a reconciled
+         * rest: parse and match only those */
+        auto withoutLastRows = [](const str& data, std::size_t rows) {
+            std::size_t end = data.size() - 1;
+            for (std::size_t r = 0; r < rows && end != str::npos; ++r)
+            {
+                end = data.rfind('\n', end - 1);
+            }
+            return std::string_view(data).substr(0, end + 1);
+        };
+        const std::size_t dayRows = std::max<std::size_t>(gen.bankRows / 365, 1);
+        const std::string_view bankHead = withoutLastRows(gen.bank, dayRows);
+        const std::string_view booksHead = withoutLastRows(gen.books, dayRows);
+        brlib::passedAndFailedVecs bankInc, booksInc;
+        brlib::results_t incResults;
+        std::size_t bankFrom = 0, booksFrom = 0;
+        const double appendSecs = bestSeconds(
+          opts.reps,
+          [&]() {
+              bankInc = {};
+              booksInc = {};
+              incResults = {};
+              brlib::parseEntries(brlib::EntryBase::EntryFrom::Bank, bankHead, bankInc, true,
+                                  bankSettings, opts.parallel);
+              brlib::parseEntries(brlib::EntryBase::EntryFrom::Books, booksHead, booksInc,
+                                  true, booksSettings, opts.parallel);
+              brlib::runReconciliation(bankInc, 0, booksInc, 0, incResults);
+              bankFrom = bankInc.passed->size();
+              booksFrom = booksInc.passed->size();
+          },
+          [&]() {
+              if (!brlib::parseAppended(brlib::EntryBase::EntryFrom::Bank, gen.bank, bankInc,
+                                        true, bankSettings, opts.parallel) ||
+                  !brlib::parseAppended(brlib::EntryBase::EntryFrom::Books, gen.books,
+                                        booksInc, true, booksSettings, opts.parallel))
+              {
+                  throw std::runtime_error(name + ": appended rows not recognised");
+              }
+              brlib::reconcileAppended(bankInc, bankFrom, booksInc, booksFrom, incResults);
+          });
+        report(name, "append",
+               bankInc.passed->size() - bankFrom + booksInc.passed->size() - booksFrom,
+               gen.bank.size() - bankHead.size() + gen.books.size() - booksHead.size(),
+               appendSecs);
+        if (incResults.matches.size() != results.matches.size())
+        {
+            std::fprintf(stderr, "%s: %zu matches appending, %zu in one run\n", name.c_str(),
+                         incResults.matches.size(), results.matches.size());
+        }
+
+        /* reopening the reconciled pair from a snapshot */
+        const str snapshot =
+          (std::filesystem::temp_directory_path() / ("brbench-" + name + ".brs")).string();
+        {
+            brlib::Session saved;
+            saved.bank = bank;
+            saved.books = books;
+            saved.results = results;
+            brlib::saveSession(snapshot, saved);
+        }
+        brlib::Session reopened;
+        const double openSecs = bestSeconds(
+          opts.reps, [&]() { reopened = {}; },
+          [&]() { brlib::openSession(snapshot, reopened); });
+        report(name, "session-open", bothRows, std::filesystem::file_size(snapshot),
+               openSecs);
+        reopened = {};
+        std::filesystem::remove(snapshot);
+
+        vec<brlib::EntryMatch> proposals;
+        brlib::RelatedSearchSettings related;
+        related.threads = opts.parallel.threads;
+        const double relatedSecs = bestSeconds(
+          opts.reps, [&]() { proposals.clear(); },
+          [&]() {
+              brlib::findRelatedRecords(results, bank.passed, books.passed, proposals,
+                                        related);
+          });
+        report(name, "related",
+               results.missingInBook.size() + results.missingInBank.size(), 0, relatedSecs);
+        /* books rows proposed for each bank row that was split */
+        std::map<std::size_t, brlib::EntryMatch::entry_set> proposedSplits;
+        for (const brlib::EntryMatch& m : proposals)
+        {
+            const brlib::EntryMatch::entry_set banks = m.banksIndices();
+            if (banks.size() == 1)
+            {
+                proposedSplits[*banks.begin()] = m.booksSet();
+            }
+        }
+        std::size_t found = 0;
+        for (const SplitGroup& g : gen.splits)
+        {
+            const auto it = proposedSplits.find(g.bankRow);
+            found += it != proposedSplits.end() &&
+                     it->second == brlib::EntryMatch::entry_set(g.booksRows.begin(),
+                                                                g.booksRows.end());
+        }
+        if (found != gen.splits.size())
+        {
+            std::fprintf(stderr, "%s: %zu of %zu split groups proposed, %zu proposals\n",
+                         name.c_str(), found, gen.splits.size(), proposals.size());
+        }
+
+        /* the generator's split groups, matched by hand as a user would */
+        vec<brlib::EntryMatch> manual;
+        std::size_t groupRows = 0;
+        const double entryMatchSecs = bestSeconds(
+          opts.reps,
+          [&]() {
+              manual.clear();
+              groupRows = 0;
+          },
+          [&]() {
+              for (const SplitGroup& g : gen.splits)
+              {
+                  brlib::EntryMatch match({}, bank.passed, books.passed, true);
+                  bool ok = match.insertIntoBank(g.bankRow, results);
+                  for (const std::size_t row : g.booksRows)
+                  {
+                      ok = ok && match.insertIntoBooks(row, results);
+                  }
+                  if (ok && match.banksSum() == match.booksSum())
+                  {
+                      groupRows += match.setsTotalSize();
+                      manual.push_back(std::move(match));
+                  }
+              }
+          });
+        report(name, "entry-match", groupRows, 0, entryMatchSecs);
+        if (manual.size() != gen.splits.size())
+        {
+            std::fprintf(stderr, "%s: %zu of %zu split groups matched by hand\n",
+                         name.c_str(), manual.size(), gen.splits.size());
+        }
+
+        /* saving them, then bringing the missing lists up to date once */
+        brlib::results_t saved;
+        const double saveSecs = bestSeconds(
+          opts.reps, [&]() { saved = results; },
+          [&]() {
+              for (const brlib::EntryMatch& m : manual)
+              {
+                  brlib::EntryMatch match(m);
+                  brlib::saveManualMatch(saved, match);
+              }
+              brlib::syncMissing(saved);
+          });
+        report(name, "manual-save", groupRows, 0, saveSecs);
+    }
+
+    void writeLayout(const Layout& layout, const Options& opts)
+    {
+        const GeneratedStatements gen = generateStatements(layout, opts.gen);
+        const std::filesystem::path dir(opts.writeDir);
+        for (const auto& [suffix, data] :
+             {std::pair{"-bank.txt", &gen.bank}, std::pair{"-books.txt", &gen.books}})
+        {
+            const std::filesystem::path path = dir / (layout.name() + suffix);
+            std::ofstream out(path, std::ios::binary);
+            out.write(data->data(), std::streamsize(data->size()));
+            if (!out)
+            {
+                throw std::runtime_error("couldn't write " + path.string());
+            }
+            std::cerr << path.string() << '\n';
+        }
+    }
+
+    int run(const Options& opts)
+    {
+        if (!opts.writeDir.empty())
+        {
+            std::filesystem::create_directories(opts.writeDir);
+        }
+        else
+        {
+            std::printf("%-24s %-12s %10s %9s %10s %14s %10s\n", "layout", "stage", "rows",
+                        "MB", "ms", "rows/s", "MB/s");
+        }
+        for (const Layout& layout : allLayouts())
+        {
+            if (layout.name().find(opts.layoutFilter) == str::npos)
+            {
+                continue;
+            }
+            if (!opts.writeDir.empty())
+            {
+                writeLayout(layout, opts);
+            }
+            else
+            {
+                runLayout(layout, opts);
+                std::fflush(stdout);
+            }
+        }
+        return 0;
+    }
+
+} // namespace brbench
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        return brbench::run(brbench::parseArgs(argc, argv));
+    }
+    catch (brbench::UsageError& e)
+    {
+        std::cerr << "brbench: " << e.what() << "\n\n" << brbench::usage;
+        return 2;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "brbench: " << e.what() << '\n';
+        return 1;
+    }
+}
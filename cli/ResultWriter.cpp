@@ -0,0 +1,205 @@
+#include <cinttypes>
+#include <cstdio>
+
+#include "ResultWriter.h"
+
+namespace brcli
+{
+
+    void ResultWriter::write(const brlib::results_t& results)
+    {
+        if (m_format == Format::Json)
+        {
+            writeJson(results);
+        }
+        else
+        {
+            writeCsv(results);
+        }
+        m_out.flush();
+    }
+
+    void ResultWriter::writeCsv(const brlib::results_t& results)
+    {
+        m_out << "section,match,side,row,date,narration,debit,credit,balance\n";
+        long matchId = 0;
+        for (const brlib::EntryMatch& match : results.matches)
+        {
+            for (const brlib::EntryPointer& e : match.data())
+            {
+                writeCsvRow(Section::Match, matchId,
+                            e.entryFor == brlib::EntryPointer::For::Bank, e.entryIdx);
+            }
+            ++matchId;
+        }
+        for (const brlib::entry_vec_sz_t idx : results.missingInBook)
+        {
+            writeCsvRow(Section::MissingInBooks, -1, true, idx);
+        }
+        for (const brlib::entry_vec_sz_t idx : results.missingInBank)
+        {
+            writeCsvRow(Section::MissingInBank, -1, false, idx);
+        }
+    }
+
+    void ResultWriter::writeCsvRow(Section section, long matchId, bool fromBank,
+                                   brlib::entry_vec_sz_t idx)
+    {
+        const brlib::EntryStore& entries = fromBank ? m_bank : m_books;
+        switch (section)
+        {
+            case Section::Match:
+                m_out << "match," << matchId;
+                break;
+            case Section::MissingInBooks:
+                m_out << "missing_in_books,";
+                break;
+            case Section::MissingInBank:
+                m_out << "missing_in_bank,";
+                break;
+        }
+        m_out << (fromBank ? ",bank," : ",books,") << idx << ',';
+        writeDate(m_out, entries.day(idx));
+        m_out << ',';
+        writeCsvField(m_out, entries.narr(idx));
+        m_out << ',';
+        writeAmount(m_out, entries.debit(idx));
+        m_out << ',';
+        writeAmount(m_out, entries.credit(idx));
+        m_out << ',';
+        writeAmount(m_out, entries.balance(idx));
+        m_out << '\n';
+    }
+
+    void ResultWriter::writeJson(const brlib::results_t& results)
+    {
+        m_out << "{\"matches\":[";
+        bool firstMatch = true;
+        for (const brlib::EntryMatch& match : results.matches)
+        {
+            m_out << (firstMatch ? "\n" : ",\n") << "{\"manual\":"
+                  << (match.isManual() ? "true" : "false") << ",\"entries\":[";
+            firstMatch = false;
+            bool firstEntry = true;
+            for (const brlib::EntryPointer& e : match.data())
+            {
+                if (!firstEntry)
+                {
+                    m_out << ',';
+                }
+                firstEntry = false;
+                writeJsonEntry(e.entryFor == brlib::EntryPointer::For::Bank, e.entryIdx);
+            }
+            m_out << "]}";
+        }
+
+        auto writeMissing = [&](const char* key, bool fromBank,
+                                const vec<brlib::entry_vec_sz_t>& missing) {
+            m_out << "],\n\"" << key << "\":[";
+            bool first = true;
+            for (const brlib::entry_vec_sz_t idx : missing)
+            {
+                m_out << (first ? "\n" : ",\n");
+                first = false;
+                writeJsonEntry(fromBank, idx);
+            }
+        };
+        writeMissing("missingInBooks", true, results.missingInBook);
+        writeMissing("missingInBank", false, results.missingInBank);
+        m_out << "]}\n";
+    }
+
+    void ResultWriter::writeJsonEntry(bool fromBank, brlib::entry_vec_sz_t idx)
+    {
+        const brlib::EntryStore& entries = fromBank ? m_bank : m_books;
+        m_out << "{\"side\":\"" << (fromBank ? "bank" : "books") << "\",\"row\":" << idx
+              << ",\"date\":\"";
+        writeDate(m_out, entries.day(idx));
+        m_out << "\",\"narration\":";
+        writeJsonString(m_out, entries.narr(idx));
+        m_out << ",\"debit\":";
+        writeAmount(m_out, entries.debit(idx));
+        m_out << ",\"credit\":";
+        writeAmount(m_out, entries.credit(idx));
+        m_out << ",\"balance\":";
+        writeAmount(m_out, entries.balance(idx));
+        m_out << '}';
+    }
+
+    void ResultWriter::writeAmount(std::ostream& os, brlib::paise_t paise)
+    {
+        char buf[32];
+        const std::uint64_t abs = paise < 0 ? 0u - std::uint64_t(paise) : std::uint64_t(paise);
+        const int len = std::snprintf(buf, sizeof(buf), "%s%" PRIu64 ".%02u", paise < 0 ? "-" : "",
+                                      abs / 100, unsigned(abs % 100));
+        os.write(buf, len);
+    }
+
+    void ResultWriter::writeDate(std::ostream& os, brlib::day_t day)
+    {
+        const std::tm t = brlib::tmFromDays(day);
+        char buf[16];
+        const int len = std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", t.tm_year + 1900,
+                                      t.tm_mon + 1, t.tm_mday);
+        os.write(buf, len);
+    }
+
+    void ResultWriter::writeCsvField(std::ostream& os, std::string_view s)
+    {
+        if (s.find_first_of(",\"\r\n") == std::string_view::npos)
+        {
+            os << s;
+            return;
+        }
+        os << '"';
+        for (const char c : s)
+        {
+            if (c == '"')
+            {
+                os << '"';
+            }
+            os << c;
+        }
+        os << '"';
+    }
+
+    void ResultWriter::writeJsonString(std::ostream& os, std::string_view s)
+    {
+        os << '"';
+        for (const char c : s)
+        {
+            switch (c)
+            {
+                case '"':
+                    os << "\\\"";
+                    break;
+                case '\\':
+                    os << "\\\\";
+                    break;
+                case '\n':
+                    os << "\\n";
+                    break;
+                case '\r':
+                    os << "\\r";
+                    break;
+                case '\t':
+                    os << "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                        os << buf;
+                    }
+                    else
+                    {
+                        os << c;
+                    }
+                    break;
+            }
+        }
+        os << '"';
+    }
+
+} // namespace brcli
@@ -0,0 +1,64 @@
+#ifndef BRCLI_RESULTWRITER_H
+#define BRCLI_RESULTWRITER_H
+
+#include <ostream>
+
+#include <EntryMatch.h>
+#include <EntryStore.h>
+#include <brlib_common.h>
+
+namespace brcli
+{
+
+    using brlib::str;
+    using brlib::vec;
+
+    /** streams reconciliation results: every matched entry with its match id,
+     * then bank entries missing in books and books entries missing in bank.
+     * dates are yyyy-mm-dd and amounts plain decimals, for other programs to
+     * read back. */
+    class ResultWriter
+    {
+    public:
+        enum class Format
+        {
+            Csv,
+            Json
+        };
+
+        ResultWriter(std::ostream& out, Format format, const brlib::EntryStore& bank,
+                     const brlib::EntryStore& books):
+            m_out(out),
+            m_format(format), m_bank(bank), m_books(books) {}
+
+        void write(const brlib::results_t& results);
+
+    private:
+        enum class Section
+        {
+            Match,
+            MissingInBooks,
+            MissingInBank
+        };
+
+        void writeCsvRow(Section section, long matchId, bool fromBank,
+                         brlib::entry_vec_sz_t idx);
+        void writeJsonEntry(bool fromBank, brlib::entry_vec_sz_t idx);
+
+        void writeCsv(const brlib::results_t& results);
+        void writeJson(const brlib::results_t& results);
+
+        static void writeAmount(std::ostream& os, brlib::paise_t paise);
+        static void writeDate(std::ostream& os, brlib::day_t day);
+        static void writeCsvField(std::ostream& os, std::string_view s);
+        static void writeJsonString(std::ostream& os, std::string_view s);
+
+        std::ostream& m_out;
+        Format m_format;
+        const brlib::EntryStore& m_bank;
+        const brlib::EntryStore& m_books;
+    };
+
+} // namespace brcli
+
+#endif // BRCLI_RESULTWRITER_H
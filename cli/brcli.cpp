@@ -0,0 +1,412 @@
+/* headless reconciliation: parse a bank and a books file, match them, and
+ * stream the results to stdout. timings and peak memory go to stderr. */
+
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <MappedFile.h>
+#include <reconcile.h>
+#include <session.h>
+
+#include "ResultWriter.h"
+
+namespace brcli
+{
+
+    class UsageError : public std::invalid_argument
+    {
+    public:
+        explicit UsageError(const str& s):
+            std::invalid_argument(s) {}
+    };
+
+    struct Options
+    {
+        str bankPath, booksPath;
+        ResultWriter::Format format{ResultWriter::Format::Csv};
+        brlib::ParseSettings parse;
+        brlib::ReconcileSettings reconcile;
+        /* skip findLastMatchingBalance and match from the first rows */
+        bool fromStart{false};
+        /* earlier rows that must agree before a balance is taken as the anchor */
+        unsigned anchorConfirm{0};
+        /* snapshot to write after matching, or to read instead of both files */
+        str saveSessionPath, sessionPath;
+    };
+
+    static const char usage[] =
+      "usage: brcli [options] <bank-file> <books-file>\n"
+      "       brcli [options] --session <snapshot>\n"
+      "\n"
+      "  -f, --format csv|json   output format (default csv)\n"
+      "  -j, --threads N         parse threads; 0 uses every core (default 0)\n"
+      "  -a, --all               match every row, not only those after the last\n"
+      "                          balance both files agree on\n"
+      "      --anchor-confirm K  only start from a shared balance if the K bank\n"
+      "                          balances before it are also in books, in order\n"
+      "      --days-early N      match books entries up to N days before the bank date\n"
+      "      --days-late N       match books entries up to N days after the bank date\n"
+      "                          (the nearest date wins; default 0, exact dates)\n"
+      "      --cross-check       verify matches against the nested-loop reference\n"
+      "      --save-session PATH write a snapshot of entries and results to PATH\n"
+      "      --session PATH      print the results of a snapshot instead of matching\n"
+      "      --manual            read columns from the --bank-* / --books-* settings\n"
+      "                          instead of detecting them from the header\n"
+      "      --{bank,books}-delim tab|pipe|comma|<char>\n"
+      "      --{bank,books}-header N      0-based row of the header\n"
+      "      --{bank,books}-date dd-mm-yy|dd/mm/yy|dd-mm-yyyy|dd/mm/yyyy\n"
+      "      --{bank,books}-cols date,narr,debit,credit,balance[,amount,type]\n"
+      "                          0-based column numbers, -1 for unused\n"
+      "  -h, --help\n";
+
+    long toNumber(std::string_view s, const char* what)
+    {
+        long value = 0;
+        const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        if (ec != std::errc() || end != s.data() + s.size())
+        {
+            throw UsageError(str("bad ") + what + ": " + str(s));
+        }
+        return value;
+    }
+
+    brlib::day_t toDayCount(std::string_view s)
+    {
+        const long days = toNumber(s, "day count");
+        if (days < 0 || days > 366)
+        {
+            throw UsageError("day count out of range: " + str(s));
+        }
+        return brlib::day_t(days);
+    }
+
+    char toDelim(std::string_view s)
+    {
+        for (const brlib::Delim& d : brlib::delims)
+        {
+            if (s.size() > 1 && d.label.starts_with(s))
+            {
+                return d.value;
+            }
+        }
+        if (s.size() == 1)
+        {
+            return s.front();
+        }
+        throw UsageError("bad delim: " + str(s));
+    }
+
+    brlib::DateFormat toDateFormat(std::string_view s)
+    {
+        for (const brlib::DateFormat& fmt : brlib::dateFormats)
+        {
+            if (fmt.label == s)
+            {
+                return fmt;
+            }
+        }
+        throw UsageError("bad date format: " + str(s));
+    }
+
+    void setCols(std::string_view s, brlib::ManualParseSettings& settings)
+    {
+        using Cols = brlib::ManualParseSettings::Cols;
+        static const Cols order[] = {Cols::Date,    Cols::Narr,   Cols::Debit,
+                                     Cols::Credit,  Cols::Balance, Cols::Amount,
+                                     Cols::TransactionType};
+        std::size_t n = 0;
+        while (!s.empty())
+        {
+            if (n == std::size(order))
+            {
+                throw UsageError("too many columns");
+            }
+            const auto comma = s.find(',');
+            settings.colIndices[order[n++]] = int(toNumber(s.substr(0, comma), "column"));
+            s.remove_prefix(comma == std::string_view::npos ? s.size() : comma + 1);
+        }
+        if (n != 5 && n != std::size(order))
+        {
+            throw UsageError("expected 5 or 7 columns");
+        }
+        settings.singleAmountCol = settings.colIndices[Cols::Amount] != -1;
+    }
+
+    Options parseArgs(int argc, char** argv)
+    {
+        Options opts;
+        vec<str> paths;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            auto value = [&]() -> std::string_view {
+                if (i + 1 >= argc)
+                {
+                    throw UsageError(str(arg) + " needs a value");
+                }
+                return argv[++i];
+            };
+            /* --bank-xxx / --books-xxx pick the side's settings */
+            auto sideSetting = [&](std::string_view& key) -> brlib::ManualParseSettings* {
+                for (const auto& [prefix, side] :
+                     {std::pair{std::string_view("--bank-"), &opts.parse.bank},
+                      std::pair{std::string_view("--books-"), &opts.parse.books}})
+                {
+                    if (arg.starts_with(prefix))
+                    {
+                        key = arg.substr(prefix.size());
+                        return side;
+                    }
+                }
+                return nullptr;
+            };
+
+            std::string_view key;
+            if (arg == "-h" || arg == "--help")
+            {
+                std::cout << usage;
+                std::exit(0);
+            }
+            else if (arg == "-f" || arg == "--format")
+            {
+                const std::string_view f = value();
+                if (f == "csv")
+                {
+                    opts.format = ResultWriter::Format::Csv;
+                }
+                else if (f == "json")
+                {
+                    opts.format = ResultWriter::Format::Json;
+                }
+                else
+                {
+                    throw UsageError("unknown format: " + str(f));
+                }
+            }
+            else if (arg == "-j" || arg == "--threads")
+            {
+                opts.parse.parallel.threads = unsigned(toNumber(value(), "thread count"));
+            }
+            else if (arg == "-a" || arg == "--all")
+            {
+                opts.fromStart = true;
+            }
+            else if (arg == "--anchor-confirm")
+            {
+                const std::string_view rows = value();
+                if (toNumber(rows, "row count") < 0)
+                {
+                    throw UsageError("bad row count: " + str(rows));
+                }
+                opts.anchorConfirm = unsigned(toNumber(rows, "row count"));
+            }
+            else if (arg == "--days-early")
+            {
+                opts.reconcile.booksDaysEarly = toDayCount(value());
+            }
+            else if (arg == "--days-late")
+            {
+                opts.reconcile.booksDaysLate = toDayCount(value());
+            }
+            else if (arg == "--cross-check")
+            {
+                opts.reconcile.crossCheck = true;
+            }
+            else if (arg == "--save-session")
+            {
+                opts.saveSessionPath = value();
+            }
+            else if (arg == "--session")
+            {
+                opts.sessionPath = value();
+            }
+            else if (arg == "--manual")
+            {
+                opts.parse.setAutoParse(false);
+            }
+            else if (brlib::ManualParseSettings* side = sideSetting(key))
+            {
+                if (key == "delim")
+                {
+                    side->delimChar = toDelim(value());
+                }
+                else if (key == "header")
+                {
+                    side->headerAt = int(toNumber(value(), "header row"));
+                }
+                else if (key == "date")
+                {
+                    side->dateFormat = toDateFormat(value());
+                }
+                else if (key == "cols")
+                {
+                    setCols(value(), *side);
+                }
+                else
+                {
+                    throw UsageError("unknown option: " + str(arg));
+                }
+            }
+            else if (arg.starts_with("-") && arg.size() > 1)
+            {
+                throw UsageError("unknown option: " + str(arg));
+            }
+            else
+            {
+                paths.emplace_back(arg);
+            }
+        }
+        if (!opts.sessionPath.empty())
+        {
+            if (!paths.empty())
+            {
+                throw UsageError("--session replaces the bank and books files");
+            }
+            return opts;
+        }
+        if (paths.size() != 2)
+        {
+            throw UsageError("expected a bank file and a books file");
+        }
+        opts.bankPath = paths[0];
+        opts.booksPath = paths[1];
+        return opts;
+    }
+
+    /* peak resident set of this process, in KiB */
+    long peakMemoryKiB()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        {
+            return long(pmc.PeakWorkingSetSize / 1024);
+        }
+        return -1;
+#else
+        struct rusage ru
+        {
+        };
+        if (getrusage(RUSAGE_SELF, &ru))
+        {
+            return -1;
+        }
+#if defined(__APPLE__)
+        return ru.ru_maxrss / 1024; /* bytes on macOS */
+#else
+        return ru.ru_maxrss;
+#endif
+#endif
+    }
+
+    int run(const Options& opts)
+    {
+        using clock = std::chrono::steady_clock;
+        auto ms = [](clock::duration d) {
+            return std::chrono::duration<double, std::milli>(d).count();
+        };
+
+        if (!opts.sessionPath.empty())
+        {
+            const auto t0 = clock::now();
+            brlib::Session session;
+            brlib::openSession(opts.sessionPath, session);
+            const auto t1 = clock::now();
+            ResultWriter(std::cout, opts.format, *session.bank.passed, *session.books.passed)
+              .write(session.results);
+            std::cerr << "bank rows: " << session.bank.passed->size()
+                      << ", books rows: " << session.books.passed->size()
+                      << ", matches: " << session.results.matches.size() << '\n'
+                      << "open: " << ms(t1 - t0) << " ms, write: " << ms(clock::now() - t1)
+                      << " ms\n";
+            return 0;
+        }
+
+        brlib::passedAndFailedVecs bank, books;
+        brlib::results_t results;
+        brlib::ParseSettings parseSettings = opts.parse;
+
+        const auto t0 = clock::now();
+        brlib::parseFiles(opts.bankPath, bank, opts.booksPath, books, parseSettings);
+        const auto t1 = clock::now();
+
+        brlib::entry_vec_sz_t bankBeg = 0, bookBeg = 0;
+        const brlib::pr_vec_t pr =
+          opts.fromStart ? brlib::pr_vec_t{0, 0} :
+                           brlib::findLastMatchingBalance(bank, books, opts.anchorConfirm);
+        if (pr.first && pr.second)
+        {
+            bankBeg = pr.first;
+            bookBeg = pr.second;
+        }
+        brlib::runReconciliation(bank, bankBeg, books, bookBeg, results, opts.reconcile);
+        const auto t2 = clock::now();
+
+        ResultWriter(std::cout, opts.format, *bank.passed, *books.passed).write(results);
+        const auto t3 = clock::now();
+
+        if (!opts.saveSessionPath.empty())
+        {
+            brlib::Session session;
+            session.bankPath = opts.bankPath;
+            session.booksPath = opts.booksPath;
+            session.bank = bank;
+            session.books = books;
+            session.results = std::move(results);
+            session.settings = parseSettings;
+            session.reconciled = true;
+            session.bankReconciledRows = bank.passed->size();
+            session.booksReconciledRows = books.passed->size();
+            brlib::saveSession(opts.saveSessionPath, session);
+            results = std::move(session.results);
+        }
+
+        std::cerr << "bank rows: " << bank.passed->size() << " (" << bank.failed->size()
+                  << " failed), books rows: " << books.passed->size() << " ("
+                  << books.failed->size() << " failed)\n"
+                  << "matches: " << results.matches.size()
+                  << ", missing in books: " << results.missingInBook.size()
+                  << ", missing in bank: " << results.missingInBank.size() << '\n'
+                  << "parse: " << ms(t1 - t0) << " ms, match: " << ms(t2 - t1)
+                  << " ms, write: " << ms(t3 - t2) << " ms\n"
+                  << "peak memory: " << peakMemoryKiB() << " KiB\n";
+        return 0;
+    }
+
+} // namespace brcli
+
+int main(int argc, char** argv)
+{
+    std::ios::sync_with_stdio(false);
+    try
+    {
+        return brcli::run(brcli::parseArgs(argc, argv));
+    }
+    catch (brcli::UsageError& e)
+    {
+        std::cerr << "brcli: " << e.what() << "\n\n" << brcli::usage;
+        return 2;
+    }
+    catch (brlib::FileOpenError& e)
+    {
+        std::cerr << "brcli: " << e.what() << '\n';
+        return 1;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "brcli: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -3,6 +3,11 @@
 
 #include <QMainWindow>
 #include <QObject>
+#include <QProgressBar>
+#include <QThread>
+#include <QTimer>
+#include <exception>
+#include <functional>
 
 /* this header is available as QObject's meta-object compilation on project
  * build */
@@ -10,6 +15,7 @@
 
 #include <EntryMatch.h>
 #include <reconcile.h>
+#include <session.h>
 
 #include "AboutDialog.h"
 #include "EntryDataModel.h"
@@ -47,6 +53,7 @@ namespace br_ui
 
     public:
         explicit BR_MainWindow(QWidget* parent = nullptr);
+        ~BR_MainWindow() override;
         void tblRowSelectionChanged(br_ui::SettingFor settingFor,
                                     const QItemSelection& deselected);
 
@@ -64,6 +71,11 @@ namespace br_ui
         QString m_bankFile, m_bookFile;
         brlib::passedAndFailedVecs m_bankVecs, m_bookVecs;
         brlib::results_t m_results;
+        /* m_results covers the rows before these; the next reconcile only
+         * matches rows appended since, until the results are cleared or a file
+         * is read afresh */
+        bool m_reconciled{false};
+        brlib::entry_vec_sz_t m_bankReconciledRows{0}, m_booksReconciledRows{0};
 
         /* m_bankTableModel manages tblMissingInBank which displays books entries
          * missing in bank */
@@ -76,8 +88,29 @@ namespace br_ui
 
         EntryDataModel m_bankDataModel, m_booksDataModel;
 
-        void readBankFile(const QString& fileName);
-        void readBookFile(const QString& fileName);
+        /* a parse or reconciliation running off the UI thread, see startJob */
+        QThread* m_job{nullptr};
+        sp<brlib::Progress> m_jobProgress;
+        /* what the job's progress counts towards: bytes, or bank rows */
+        std::size_t m_jobTotal{0};
+        bool m_jobCountsBytes{false};
+        QTimer m_jobTimer;
+        QProgressBar* m_jobBar{nullptr};
+        QPushButton* m_jobCancel{nullptr};
+
+        /** run work on a thread of its own, its progress against total shown in
+         * the status bar with a button to cancel it, then done on the UI thread
+         * with whatever work threw, if anything. one job at a time. until done,
+         * nothing may change the entries or results: the controls that would
+         * are off, and what the window shows stays as it was. */
+        void startJob(const QString& what, std::size_t total, bool countsBytes,
+                      std::function<void(brlib::Progress&)> work,
+                      std::function<void(std::exception_ptr)> done);
+        void setJobRunning(bool running);
+        void updateJobProgress();
+
+        /* parse fileName on a job and hand the entries over when it's done */
+        void readFile(br_ui::SettingFor settingFor, const QString& fileName);
         void setUpTables();
         void connectSignals();
 
@@ -85,7 +118,11 @@ namespace br_ui
         void updateBtnReconcile();
 
         /* calls updateVec on table models so they can update their rowCount */
-        void updateTablesData(const bool afterSaveMatch = false);
+        void updateTablesData();
+
+        /* narrow the missing and matches tables to dtFrom..dtTo as they're
+         * edited; the models only search their day-ordered rows */
+        void filterTables();
 
         /* write settings to file to pick on next boot */
         void updateSettingsFile() const;
@@ -94,8 +131,8 @@ namespace br_ui
         static std::pair<str, str> findSetting(std::ifstream& fs, const str& key);
         void setTitle();
 
-        void clearBankData();
-        void clearBooksData();
+        /* drops the results and the selection being matched */
+        void clearResults();
         void showErrorMessage(const QString& title, const QString& message);
 
         brlib::sp<brlib::EntryMatch> currEntryMatch;
@@ -134,8 +171,12 @@ namespace br_ui
         void openFile(const QString& fileName, br_ui::SettingFor settingFor);
         void btnReconcileClicked();
         void btnClearClicked();
+        /* snapshot of both files' entries, the results and parse settings */
+        void saveSessionDialog();
+        void openSessionDialog();
+        void openSession(const QString& fileName);
         void updateAutoParseSetting(bool state);
-        void updateDates(const brlib::entry_vec& entryVec);
+        void updateDates(const brlib::EntryStore& entries);
     };
 } // namespace br_ui
 
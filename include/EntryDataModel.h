@@ -4,7 +4,7 @@
 #include <QAbstractTableModel>
 #include <utility>
 
-#include <EntryBase.h>
+#include <EntryStore.h>
 
 #include "helpers.h"
 
@@ -16,7 +16,7 @@ namespace br_ui
         Q_OBJECT
     public:
         explicit EntryDataModel(QObject* parent = nullptr,
-                                sp<vec<brlib::EntryBase>> entries = nullptr):
+                                sp<brlib::EntryStore> entries = nullptr):
             QAbstractTableModel(parent),
             m_entries(std::move(entries)) {}
         [[nodiscard]] int
@@ -37,7 +37,9 @@ namespace br_ui
             ED_Credit,
             ED_Balance
         };
-        sp<vec<brlib::EntryBase>> m_entries;
+        sp<brlib::EntryStore> m_entries;
+        /* display strings of every entry, as of the last updateVec */
+        EntryStrings m_strings;
         static QVariant alignmentData(int column);
     };
 
@@ -1,6 +1,8 @@
 #ifndef BR_MATCHEDENTRYMODEL_H
 #define BR_MATCHEDENTRYMODEL_H
 
+#include <limits>
+
 #include <QAbstractItemModel>
 
 #include <EntryMatch.h>
@@ -24,8 +26,8 @@ namespace br_ui
             EM_Credit
         };
         explicit EntryMatchModel(QObject* parent, vec<brlib::EntryMatch>* matches,
-                                 vec<brlib::EntryBase>* bankEntries,
-                                 vec<brlib::EntryBase>* booksEntries);
+                                 brlib::EntryStore* bankEntries,
+                                 brlib::EntryStore* booksEntries);
         [[nodiscard]] int
           rowCount(const QModelIndex& parent = QModelIndex()) const override;
         [[nodiscard]] int columnCount(const QModelIndex& parent) const override;
@@ -34,16 +36,41 @@ namespace br_ui
         [[nodiscard]] QVariant data(const QModelIndex& index,
                                     int role) const override;
 
+        /* take the matches afresh, then show those dated from..to */
         bool updateVec(const QDate* from = nullptr, const QDate* to = nullptr);
+        /* show the matches dated from..to, or all of them without dates. a match
+         * is dated by its earliest entry and shown whole. */
+        void setDateRange(const QDate* from = nullptr, const QDate* to = nullptr);
+        /* add the rows of (*matches)[m], just appended, in day order, with one
+         * insert signal rather than a reset */
+        void appendMatch(std::size_t m);
         void clearManualMatches();
 
     private:
         vec<brlib::EntryMatch>* m_matches;
-        vec<brlib::EntryBase>*m_bankEntries, *m_bookEntries;
+        brlib::EntryStore *m_bankEntries, *m_bookEntries;
 
-        brlib::EntryBase* entry(const brlib::EntryPointer& entryPtr) const;
+        /* store holding the pointed-to entry, or nullptr if the index is out of range */
+        brlib::EntryStore* store(const brlib::EntryPointer& entryPtr) const;
+        /* day of the match's earliest entry, or noDay if none is in range */
+        brlib::day_t firstDay(const brlib::EntryMatch& match) const;
+        static constexpr brlib::day_t noDay = std::numeric_limits<brlib::day_t>::max();
+        /* rows of m_data showing the matches [first, last) of m_days */
+        std::pair<std::size_t, std::size_t>
+          rowsFor(std::pair<std::size_t, std::size_t> matches) const;
 
+        /* rows of every match by day: its entries, then a blank separator */
         vec<const brlib::EntryPointer*> m_data;
+        /* display strings of m_data's entries, row for row; blank for separators */
+        EntryStrings m_strings;
+        /* per match in m_data, its day and first row; one more first row ends it */
+        vec<brlib::day_t> m_days;
+        vec<std::size_t> m_firstRows;
+        /* m_data[m_begin, m_end) is in the date range; row r shows m_begin + r */
+        std::size_t m_begin{0}, m_end{0};
+        /* m_days[m_first, m_last) are the matches in the date range */
+        std::size_t m_first{0}, m_last{0};
+        day_bounds_t m_bounds{dayBounds(nullptr, nullptr)};
     };
 
 } // namespace br_ui
@@ -3,7 +3,7 @@
 
 #include <iomanip>
 
-#include <EntryBase.h>
+#include <EntryStore.h>
 #include <QAbstractTableModel>
 
 #include "brlib_common.h"
@@ -21,9 +21,9 @@ namespace br_ui
             Bank,
             Books
         };
-        using missing_t = vec<vec<brlib::EntryBase>::size_type>;
+        using missing_t = vec<brlib::entry_vec_sz_t>;
 
-        explicit MissingEntryModel(QObject* parent, vec<brlib::EntryBase>* entries,
+        explicit MissingEntryModel(QObject* parent, brlib::EntryStore* entries,
                                    missing_t* missing);
 
         int rowCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -36,13 +36,29 @@ namespace br_ui
         [[nodiscard]] QVariant data(const QModelIndex& index,
                                     int role) const override;
 
+        /* take the missing entries afresh, then show those dated from..to */
         bool updateVec(const QDate* from = nullptr, const QDate* to = nullptr);
+        /* show the entries dated from..to, or all of them without dates */
+        void setDateRange(const QDate* from = nullptr, const QDate* to = nullptr);
+        /* drop the rows of entries, by binary search, with a remove signal per
+         * row shown rather than a reset */
+        void removeEntries(const missing_t& entries);
         brlib::entry_vec_sz_t getIndex(const QModelIndex& idx) const;
 
     private:
-        vec<brlib::EntryBase>* m_entries;
+        /* m_data's order: by day, then index */
+        bool before(brlib::entry_vec_sz_t lhs, brlib::entry_vec_sz_t rhs) const;
+
+        brlib::EntryStore* m_entries;
         missing_t* m_missingIndices;
+        /* the missing entries by day, then index, with their days */
         missing_t m_data;
+        vec<brlib::day_t> m_days;
+        /* display strings of m_data's entries, row for row */
+        EntryStrings m_strings;
+        /* m_data[m_begin, m_end) is in the date range; row r shows m_begin + r */
+        std::size_t m_begin{0}, m_end{0};
+        day_bounds_t m_bounds{dayBounds(nullptr, nullptr)};
     };
 
 } // namespace br_ui
@@ -3,9 +3,17 @@
 
 #include <QAbstractTableModel>
 #include <QDate>
+#include <QHash>
 
 #include <brlib_common.h>
 
+class QTableView;
+
+namespace brlib
+{
+    class EntryStore;
+}
+
 namespace br_ui
 {
 
@@ -26,6 +34,13 @@ namespace br_ui
         Balance
     };
 
+    enum Roles
+    {
+        /* headerData role: the widest text a column's rows hold, as far as the
+         * model knows without looking at every row; fitColumns measures it */
+        WidestTextRole = Qt::UserRole + 1
+    };
+
     QHash<int, QByteArray> getCommonRoleNames();
 
     QVariant getCommonTextAlignment(const int& col);
@@ -38,7 +53,71 @@ namespace br_ui
     };
     static const QDate today(QDateTime::currentDateTime().date());
 
-    QDate dateFromEntry(const brlib::EntryBase& entry);
+    QDate dateFromDay(brlib::day_t day);
+    brlib::day_t dayFromDate(const QDate& date);
+
+    using day_bounds_t = std::pair<brlib::day_t, brlib::day_t>;
+
+    /* first and last day of from..to; every day without both dates */
+    day_bounds_t dayBounds(const QDate* from, const QDate* to);
+
+    /* [begin, end) of days, ascending, that fall within bounds, by two binary
+     * searches */
+    std::pair<std::size_t, std::size_t> dayRange(const vec<brlib::day_t>& days,
+                                                 day_bounds_t bounds);
+
+    /** size table's columns to fit their header, the first and last
+     * sampleRows rows and the column's WidestTextRole text. stands in for
+     * resizeColumnsToContents, which asks data() of far more rows; a longer
+     * narration further down may be cut short. */
+    void fitColumns(QTableView* table, int sampleRows = 50);
+
+    /* narration of entry i, converted per call; it needs no formatting */
+    QString narrString(const brlib::EntryStore& entries, brlib::entry_vec_sz_t i);
+
+    /* date and money strings of a model's rows, formatted in bulk with
+     * brlib::formatDay / formatMoney when the rows change, so data() is a
+     * lookup. equal dates and zero amounts share one string. */
+    class EntryStrings
+    {
+    public:
+        struct Row
+        {
+            QString date, debit, credit, balance;
+        };
+
+        void clear();
+        void reserve(std::size_t rows) { m_rows.reserve(rows); }
+        /* the next row shows entry i; balance stays empty unless asked for */
+        void append(const brlib::EntryStore& entries, brlib::entry_vec_sz_t i,
+                    bool withBalance = false);
+        /* a row with nothing to show */
+        void appendBlank() { m_rows.emplace_back(); }
+        /* as append / appendBlank, before row */
+        void insert(std::size_t row, const brlib::EntryStore& entries,
+                    brlib::entry_vec_sz_t i, bool withBalance = false);
+        void insertBlank(std::size_t row) { m_rows.emplace(m_rows.begin() + row); }
+        void erase(std::size_t row) { m_rows.erase(m_rows.begin() + row); }
+
+        [[nodiscard]] std::size_t size() const { return m_rows.size(); }
+        const Row& operator[](std::size_t row) const { return m_rows[row]; }
+
+        /* the row's string for a Date, Debit, Credit or Balance column */
+        static const QString& column(const Row& row, TableCols col);
+        /* per column, the longest string formatted since clear; amounts set
+         * the widths, so the largest amounts of a model are there */
+        const Row& widest() const { return m_widest; }
+
+    private:
+        Row format(const brlib::EntryStore& entries, brlib::entry_vec_sz_t i,
+                   bool withBalance);
+        QString money(brlib::paise_t paise);
+
+        vec<Row> m_rows;
+        Row m_widest;
+        QHash<brlib::day_t, QString> m_days;
+        QString m_zero;
+    };
 
 } // namespace br_ui
 
@@ -1,11 +1,13 @@
 #include <QComboBox>
 #include <QCoreApplication>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 
 #include <brlib_common.h>
 
 #include "BR_MainWindow.h"
+#include "MappedFile.h"
 #include "parse.h"
 
 namespace br_ui
@@ -24,6 +26,15 @@ namespace br_ui
     {
 
         setupUi(this);
+        /* a running job's progress, and a way to stop it */
+        m_jobBar = new QProgressBar(statusbar);
+        m_jobBar->setRange(0, 1000);
+        m_jobCancel = new QPushButton("Cancel", statusbar);
+        statusbar->addPermanentWidget(m_jobBar);
+        statusbar->addPermanentWidget(m_jobCancel);
+        m_jobBar->hide();
+        m_jobCancel->hide();
+
         setTitle();    // With version.
         setUpTables(); // Connect models.
         connectSignals();
@@ -38,11 +49,24 @@ namespace br_ui
         dtTo->setDate(today);
 
         /** construct a locale with brlib::indianmoneypunct, and let cout imbue it,
-   * so ostrinstream in tablemodels' print members can later imbue from cout. */
+   * so EntryMatch::printMoney can later imbue from cout. table cells don't
+   * use it; the models format with brlib::formatMoney. */
         std::cout.imbue(std::locale(std::cout.getloc(), new brlib::indianMoneyPunct));
         //  loadFileProperties();
     }
 
+    BR_MainWindow::~BR_MainWindow()
+    {
+        /* a job reads this window's stores; stop it before they go */
+        if (m_job)
+        {
+            m_jobProgress->cancel = true;
+            disconnect(m_job, nullptr, this, nullptr);
+            m_job->wait();
+            delete m_job;
+        }
+    }
+
     void BR_MainWindow::onExit() { QCoreApplication::quit(); }
 
     void BR_MainWindow::openFileDialog(SettingFor dialogFor)
@@ -77,15 +101,9 @@ namespace br_ui
         {
             QObject::disconnect(m_dialogConnection);
         }
-        if (dialogFor == SettingFor::Bank)
-        {
-            m_bankFile = file;
-            readBankFile(file);
-        }
-        else if (dialogFor == SettingFor::Books)
+        if (dialogFor == SettingFor::Bank || dialogFor == SettingFor::Books)
         {
-            m_bookFile = file;
-            readBookFile(file);
+            readFile(dialogFor, file);
         }
         else
         {
@@ -93,89 +111,117 @@ namespace br_ui
         }
     }
 
-    void BR_MainWindow::readBankFile(const QString& fileName)
+    void BR_MainWindow::readFile(SettingFor settingFor, const QString& fileName)
     {
-        std::fstream file(fileName.toStdString().data());
-        if (file.is_open())
-        {
-            try
+        const bool isBank = settingFor == SettingFor::Bank;
+        const QString side = isBank ? "bank" : "books";
+        const auto from =
+          isBank ? brlib::EntryBase::EntryFrom::Bank : brlib::EntryBase::EntryFrom::Books;
+        const brlib::passedAndFailedVecs current = isBank ? m_bankVecs : m_bookVecs;
+        const bool autoParse = m_options.isAutoParseEnabled();
+        const brlib::ParallelParseSettings parallel = m_options.parallel;
+        const str path = fileName.toStdString();
+        const str noData = "no data found in " + side.toStdString() + " file.";
+
+        /* parsed into stores of its own, the whole file or only the rows it
+         * gained; the window's are only read meanwhile, and take the new
+         * entries over once the parse is through */
+        auto parsed = std::make_shared<brlib::passedAndFailedVecs>();
+        auto options = std::make_shared<brlib::ManualParseSettings>(
+          isBank ? m_options.bank : m_options.books);
+        auto appended = std::make_shared<bool>(false);
+        /* a store opened from a session is still mapped, and copied in before
+         * it can grow; the job makes that copy rather than the UI thread */
+        auto owned = std::make_shared<brlib::EntryStore>(from);
+
+        auto work = [=](brlib::Progress& progress) {
+            /* a re-export of the same statement only adds rows at the end */
+            if (!current.passed->empty())
             {
-                brlib::parseEntries(brlib::EntryBase::EntryFrom::Bank, file, m_bankVecs,
-                                    m_options.isAutoParseEnabled(), m_options.bank);
-                if (m_bankVecs.passed->empty())
-                {
-                    throw EmptyDataError("no data found in bank file.");
-                }
-                updateDates(*m_bankVecs.passed);
-                lblBankFile->setText(m_bankFile);
-                updateBtnReconcile();
+                *appended = brlib::parseFileAppended(from, path, current, *parsed, autoParse,
+                                                     *options, parallel, &progress);
             }
-            catch (EmptyDataError& e)
+            if (!*appended)
             {
-                qDebug() << "No data in bank file [" + fileName + ']';
-                clearBankData();
-                showErrorMessage("No data in bank file.", e.what());
-                m_bankFile.clear();
+                brlib::parseFile(from, path, *parsed, autoParse, *options, parallel,
+                                 &progress);
+                if (parsed->passed->empty())
+                {
+                    throw EmptyDataError(noData);
+                }
             }
-            catch (std::invalid_argument& e)
+            else if (current.passed->isMapped())
             {
-                qWarning() << "Invalid argument in bank file [" + fileName + "]\n" +
-                                e.what();
-                clearBankData();
-                showErrorMessage("Error parsing data", e.what());
-                m_bankFile.clear();
+                *owned = *current.passed;
+                owned->append(*parsed->passed);
+                parsed->passed->clear();
             }
-        }
-        else
-        {
-            showErrorMessage("Error opening bank file.", "File could not be opened.");
-            qDebug() << fileName + " couldn't be opened";
-        }
-    }
+        };
 
-    void BR_MainWindow::readBookFile(const QString& fileName)
-    {
-        std::fstream file(fileName.toStdString().data());
-        if (file.is_open())
-        {
+        auto done = [=, this](std::exception_ptr error) {
             try
             {
-                brlib::parseEntries(brlib::EntryBase::EntryFrom::Books, file, m_bookVecs,
-                                    m_options.isAutoParseEnabled(), m_options.books);
-                if (m_bookVecs.passed->empty())
+                if (error)
                 {
-                    throw EmptyDataError("no data found in books file.");
+                    std::rethrow_exception(error);
                 }
-                updateDates(*m_bookVecs.passed);
-                lblBookFile->setText(m_bookFile);
-                updateBtnReconcile();
+            }
+            catch (brlib::Cancelled& e)
+            {
+                statusbar->showMessage("Reading " + side + " file cancelled.", 5000);
+                return;
+            }
+            catch (brlib::FileOpenError& e)
+            {
+                showErrorMessage("Error opening " + side + " file.",
+                                 "File could not be opened.");
+                qWarning() << fileName + " couldn't be opened.";
+                return;
             }
             catch (EmptyDataError& e)
             {
-                qDebug() << "No data in books file [" + fileName + ']';
-                clearBooksData();
-                showErrorMessage("Error parsing data", e.what());
-                m_bookFile.clear();
+                qDebug() << "No data in " + side + " file [" + fileName + ']';
+                showErrorMessage("No data in " + side + " file.", e.what());
+                return;
             }
-            catch (std::invalid_argument& e)
+            catch (std::exception& e)
             {
-                qWarning() << "Invalid argument in books file [" + fileName + "]\n" +
-                                e.what();
-                clearBooksData();
+                qWarning() << "Error in " + side + " file [" + fileName + "]\n" + e.what();
                 showErrorMessage("Error parsing data", e.what());
-                m_bookFile.clear();
+                return;
             }
-        }
-        else
-        {
-            showErrorMessage("Error opening books file.", "File could not be opened.");
-            qWarning() << "Books file: " + fileName + " couldn't be opened.";
-        }
+
+            brlib::passedAndFailedVecs& vecs = isBank ? m_bankVecs : m_bookVecs;
+            if (*appended)
+            {
+                if (vecs.passed->isMapped())
+                {
+                    *vecs.passed = std::move(*owned);
+                }
+                brlib::appendParsed(vecs, *parsed);
+            }
+            else
+            {
+                /* results only stay good for a file that grew */
+                clearResults();
+                *vecs.passed = std::move(*parsed->passed);
+                *vecs.failed = std::move(*parsed->failed);
+                vecs.prefix = parsed->prefix;
+            }
+            (isBank ? m_options.bank : m_options.books) = *options;
+            (isBank ? m_bankFile : m_bookFile) = fileName;
+            (isBank ? lblBankFile : lblBookFile)->setText(fileName);
+            updateDates(*vecs.passed);
+            updateBtnReconcile();
+            updateTablesData();
+        };
+        startJob("Reading " + side + " file", QFileInfo(fileName).size(), true, work,
+                 done);
     }
 
     void BR_MainWindow::updateBtnReconcile()
     {
-        if (!m_bankVecs.passed->empty() && !m_bookVecs.passed->empty())
+        if (!m_job && !m_bankVecs.passed->empty() && !m_bookVecs.passed->empty())
         {
             btnRunReconciliation->setEnabled(true);
         }
@@ -187,44 +233,165 @@ namespace br_ui
 
     void BR_MainWindow::btnReconcileClicked()
     {
-        bool needTableUpdating = false;
-        if (!m_results.matches.empty())
+        /* the job reads the stores, and m_results when incremental. a fresh run's
+         * results replace m_results once it's through; an incremental one only
+         * hands over the new matches and missing lists */
+        const bool incremental = m_reconciled;
+        const brlib::passedAndFailedVecs bank = m_bankVecs, books = m_bookVecs;
+        const brlib::entry_vec_sz_t bankFrom = m_bankReconciledRows,
+                                    booksFrom = m_booksReconciledRows;
+        const brlib::results_t* current = &m_results;
+        auto results = std::make_shared<brlib::results_t>();
+        auto added = std::make_shared<brlib::AppendedMatches>();
+        std::size_t total = bank.passed->size();
+        if (incremental)
         {
-            m_results.matches.clear();
-            needTableUpdating = true;
+            total = total - std::min(total, bankFrom) + m_results.missingInBook.size();
         }
-        if (!m_results.missingInBank.empty())
+
+        auto work = [=](brlib::Progress& progress) {
+            if (incremental)
+            {
+                /* files only grew since the last run; keep its matches, manual
+                 * ones included, and match the new rows */
+                *added = brlib::matchAppended(bank, bankFrom, books, booksFrom, *current, {},
+                                              &progress);
+                return;
+            }
+            brlib::pr_vec_t pr = brlib::findLastMatchingBalance(bank, books);
+            brlib::entry_vec_sz_t bankBeg = 0;
+            brlib::entry_vec_sz_t bookBeg = 0;
+            if (pr.first && pr.second)
+            {
+                bankBeg = pr.first;
+                bookBeg = pr.second;
+            }
+            /* rows before the anchor count as done */
+            progress.rowsMatched += bankBeg;
+            runReconciliation(bank, bankBeg, books, bookBeg, *results, {}, &progress);
+        };
+
+        auto done = [=, this](std::exception_ptr error) {
+            try
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+            catch (brlib::Cancelled& e)
+            {
+                statusbar->showMessage("Reconciliation cancelled.", 5000);
+                return;
+            }
+            catch (std::exception& e)
+            {
+                showErrorMessage("Error reconciling", e.what());
+                return;
+            }
+            if (incremental)
+            {
+                brlib::applyAppended(m_results, std::move(*added));
+            }
+            else
+            {
+                m_results = std::move(*results);
+            }
+            m_reconciled = true;
+            m_bankReconciledRows = m_bankVecs.passed->size();
+            m_booksReconciledRows = m_bookVecs.passed->size();
+            updateTablesData();
+            if (!incremental)
+            {
+                currEntryMatch = std::make_shared<brlib::EntryMatch>(
+                  std::vector<brlib::EntryPointer>(), m_bankVecs.passed, m_bookVecs.passed,
+                  true);
+            }
+            //  updateSettingsFile();
+            /* one-to-many proposals have no view yet. Will be shown later */
+            // vec<brlib::EntryMatch> proposals;
+            // brlib::findRelatedRecords(m_results, m_bankVecs.passed, m_bookVecs.passed,
+            // proposals);
+        };
+        startJob("Reconciling", total, false, work, done);
+    }
+
+    void BR_MainWindow::startJob(const QString& what, std::size_t total, bool countsBytes,
+                                 std::function<void(brlib::Progress&)> work,
+                                 std::function<void(std::exception_ptr)> done)
+    {
+        if (m_job)
         {
-            m_results.missingInBank.clear();
-            needTableUpdating = true;
+            return;
         }
-        if (!m_results.missingInBook.empty())
+        auto progress = std::make_shared<brlib::Progress>();
+        auto error = std::make_shared<std::exception_ptr>();
+        m_jobProgress = progress;
+        m_jobTotal = total;
+        m_jobCountsBytes = countsBytes;
+        m_job = QThread::create([work = std::move(work), progress, error]() {
+            try
+            {
+                work(*progress);
+            }
+            catch (...)
+            {
+                *error = std::current_exception();
+            }
+        });
+        /* finished comes from the job's thread; this runs on the UI thread */
+        connect(m_job, &QThread::finished, this, [this, done = std::move(done), error]() {
+            m_job->deleteLater();
+            m_job = nullptr;
+            m_jobProgress.reset();
+            setJobRunning(false);
+            done(*error);
+        });
+        statusbar->showMessage(what + "...");
+        setJobRunning(true);
+        m_job->start();
+    }
+
+    void BR_MainWindow::setJobRunning(bool running)
+    {
+        btnBankFile->setEnabled(!running);
+        btnBookFile->setEnabled(!running);
+        btnClear->setEnabled(!running);
+        chkAutoParse->setEnabled(!running);
+        actionOpenSession->setEnabled(!running);
+        btnBankFileSettings->setEnabled(!running && !m_options.isAutoParseEnabled());
+        btnBooksFileSettings->setEnabled(!running && !m_options.isAutoParseEnabled());
+        if (running)
         {
-            m_results.missingInBook.clear();
-            needTableUpdating = true;
+            btnRunReconciliation->setEnabled(false);
+            btnMatchSelected->setEnabled(false);
+            m_jobBar->setValue(0);
+            m_jobCancel->setEnabled(true);
+            m_jobTimer.start(100);
         }
-        if (needTableUpdating)
+        else
         {
-            updateTablesData();
+            m_jobTimer.stop();
+            statusbar->clearMessage();
+            updateBtnReconcile();
+            if (currEntryMatch)
+            {
+                updateBtnSaveMatch();
+            }
         }
-        brlib::pr_vec_t pr = brlib::findLastMatchingBalance(m_bankVecs, m_bookVecs);
-        brlib::entry_vec_sz_t bankBeg = 0;
-        brlib::entry_vec_sz_t bookBeg = 0;
-        if (pr.first && pr.second)
+        m_jobBar->setVisible(running);
+        m_jobCancel->setVisible(running);
+    }
+
+    void BR_MainWindow::updateJobProgress()
+    {
+        if (!m_jobProgress || !m_jobTotal)
         {
-            bankBeg = pr.first;
-            bookBeg = pr.second;
+            return;
         }
-        runReconciliation(m_bankVecs, bankBeg, m_bookVecs, bookBeg, m_results);
-        updateTablesData();
-        currEntryMatch = std::make_shared<brlib::EntryMatch>(
-          std::vector<brlib::EntryPointer>(), m_bankVecs.passed, m_bookVecs.passed,
-          true);
-        //  updateSettingsFile();
-        /* find possible relations is a WIP. Will be implemented later */
-        // vec<brlib::PossibleRelation> relns;
-        // brlib::findRelatedRecords(m_results, m_bankVecs.passed, m_bookVecs.passed,
-        // relns);
+        const std::size_t done = m_jobCountsBytes ? m_jobProgress->bytesParsed.load()
+                                                  : m_jobProgress->rowsMatched.load();
+        m_jobBar->setValue(static_cast<int>(std::min(done, m_jobTotal) * 1000 / m_jobTotal));
     }
 
     std::pair<str, str> BR_MainWindow::findSetting(std::ifstream& fs,
@@ -274,32 +441,109 @@ namespace br_ui
     //     qDebug() << "couldn't find settings file.";
     //   }
     // }
-    void BR_MainWindow::clearBankData()
+    void BR_MainWindow::clearResults()
     {
-        if (!m_bankVecs.passed->empty())
-            m_bankVecs.passed->clear();
-        if (!m_bankVecs.failed->empty())
-            m_bankVecs.failed->clear();
+        m_results.matches.clear();
+        m_results.missingInBank.clear();
+        m_results.missingInBook.clear();
+        m_results.bankMatched.clear();
+        m_results.booksMatched.clear();
+        m_results.bankMissing.clear();
+        m_results.booksMissing.clear();
+        m_results.missingStale = false;
+        m_reconciled = false;
+        if (currEntryMatch)
+        {
+            currEntryMatch->clear();
+        }
+        updateMatchesText();
     }
 
-    void BR_MainWindow::clearBooksData()
+    void BR_MainWindow::btnClearClicked()
     {
-        if (!m_bookVecs.passed->empty())
-            m_bookVecs.passed->clear();
-        if (!m_bookVecs.failed->empty())
-            m_bookVecs.failed->clear();
+        clearResults();
+        updateTablesData();
     }
 
-    void BR_MainWindow::btnClearClicked()
+    void BR_MainWindow::saveSessionDialog()
+    {
+        const QString fileName = QFileDialog::getSaveFileName(
+          this, "Save session", "", "Reconciliation Sessions (*.brs)");
+        if (fileName.isEmpty())
+        {
+            return;
+        }
+        brlib::Session session;
+        session.bankPath = m_bankFile.toStdString();
+        session.booksPath = m_bookFile.toStdString();
+        session.bank = m_bankVecs;
+        session.books = m_bookVecs;
+        session.results = m_results;
+        session.settings = m_options;
+        session.reconciled = m_reconciled;
+        session.bankReconciledRows = m_bankReconciledRows;
+        session.booksReconciledRows = m_booksReconciledRows;
+        try
+        {
+            brlib::saveSession(fileName.toStdString(), session);
+        }
+        catch (brlib::FileOpenError& e)
+        {
+            showErrorMessage("Error saving session.", e.what());
+        }
+    }
+
+    void BR_MainWindow::openSessionDialog()
     {
-        if (!m_results.matches.empty())
-            m_results.matches.clear();
-        if (!m_results.missingInBook.empty())
-            m_results.missingInBank.clear();
-        if (!m_results.missingInBook.empty())
-            m_results.missingInBook.clear();
+        const QString fileName = QFileDialog::getOpenFileName(
+          this, "Open session", "", "Reconciliation Sessions (*.brs)");
+        if (!fileName.isEmpty())
+        {
+            openSession(fileName);
+        }
+    }
 
+    void BR_MainWindow::openSession(const QString& fileName)
+    {
+        /* the snapshot fills the stores the models already hold */
+        brlib::Session session;
+        session.bank = m_bankVecs;
+        session.books = m_bookVecs;
+        try
+        {
+            brlib::openSession(fileName.toStdString(), session);
+        }
+        catch (std::runtime_error& e)
+        {
+            showErrorMessage("Error opening session.", e.what());
+            return;
+        }
+        m_bankVecs.prefix = session.bank.prefix;
+        m_bookVecs.prefix = session.books.prefix;
+        m_results = std::move(session.results);
+        m_options = session.settings;
+        m_reconciled = session.reconciled;
+        m_bankReconciledRows = session.bankReconciledRows;
+        m_booksReconciledRows = session.booksReconciledRows;
+        m_bankFile = QString::fromStdString(session.bankPath);
+        m_bookFile = QString::fromStdString(session.booksPath);
+
+        chkAutoParse->setChecked(m_options.isAutoParseEnabled());
+        lblBankFile->setText(m_bankFile);
+        lblBookFile->setText(m_bookFile);
+        if (!m_bankVecs.passed->empty())
+        {
+            updateDates(*m_bankVecs.passed);
+        }
+        if (!m_bookVecs.passed->empty())
+        {
+            updateDates(*m_bookVecs.passed);
+        }
+        updateBtnReconcile();
         updateTablesData();
+        currEntryMatch = std::make_shared<brlib::EntryMatch>(
+          std::vector<brlib::EntryPointer>(), m_bankVecs.passed, m_bookVecs.passed,
+          true);
     }
 
     void BR_MainWindow::showErrorMessage(const QString& title,
@@ -357,6 +601,10 @@ namespace br_ui
     {
         chkAutoParse->setChecked(m_options.isAutoParseEnabled());
         connect(actionExit_2, &QAction::triggered, this, &BR_MainWindow::onExit);
+        connect(actionOpenSession, &QAction::triggered, this,
+                &BR_MainWindow::openSessionDialog);
+        connect(actionSaveSession, &QAction::triggered, this,
+                &BR_MainWindow::saveSessionDialog);
         connect(btnBankFile, &QPushButton::clicked, this,
                 [&]() {
                     openFileDialog(SettingFor::Bank);
@@ -386,6 +634,18 @@ namespace br_ui
 
         connect(actionAbout_2, &QAction::triggered, this,
                 &BR_MainWindow::openAboutDialog);
+
+        connect(dtFrom, &QDateEdit::dateChanged, this, &BR_MainWindow::filterTables);
+        connect(dtTo, &QDateEdit::dateChanged, this, &BR_MainWindow::filterTables);
+
+        connect(&m_jobTimer, &QTimer::timeout, this, &BR_MainWindow::updateJobProgress);
+        connect(m_jobCancel, &QPushButton::clicked, this, [&]() {
+            if (m_jobProgress)
+            {
+                m_jobProgress->cancel = true;
+                m_jobCancel->setEnabled(false);
+            }
+        });
         toggleSelectionConnections();
     }
 
@@ -411,32 +671,38 @@ namespace br_ui
         }
     }
 
-    void BR_MainWindow::updateTablesData(const bool afterSaveMatch)
+    void BR_MainWindow::updateTablesData()
     {
         const QDate& from = dtFrom->date();
         const QDate& to = dtTo->date();
+        /* the missing tables read the lists, so drop what manual matches took */
+        brlib::syncMissing(m_results);
         m_bankTableModel.updateVec(&from, &to);
         m_bookTableModel.updateVec(&from, &to);
         m_matchesTableModel.updateVec(&from, &to);
+        m_bankDataModel.updateVec();
+        m_booksDataModel.updateVec();
 
-        /* don't update below tables unnecessarily */
-        if (!afterSaveMatch)
+        QTableView* tables[] = {tblMissingInBank, tblMissingInBooks, tblMatches, tblBank,
+                                tblBooks};
+        for (QTableView*& t : tables)
         {
-            m_bankDataModel.updateVec();
-            m_booksDataModel.updateVec();
-
-            QTableView* tables[] = {tblMissingInBank, tblMissingInBooks, tblMatches,
-                                    tblBank, tblBooks};
-            for (QTableView*& t : tables)
+            if (t->model()->rowCount())
             {
-                if (t->model()->rowCount())
-                {
-                    t->resizeColumnsToContents();
-                }
+                fitColumns(t);
             }
         }
     }
 
+    void BR_MainWindow::filterTables()
+    {
+        const QDate& from = dtFrom->date();
+        const QDate& to = dtTo->date();
+        m_bankTableModel.setDateRange(&from, &to);
+        m_bookTableModel.setDateRange(&from, &to);
+        m_matchesTableModel.setDateRange(&from, &to);
+    }
+
     void BR_MainWindow::updateSettingsFile() const
     {
         const char origName[] = "settings.txt";
@@ -505,12 +771,10 @@ namespace br_ui
         }
     }
 
-    void BR_MainWindow::updateDates(const brlib::entry_vec& entryVec)
+    void BR_MainWindow::updateDates(const brlib::EntryStore& entries)
     {
-        const brlib::EntryBase& last = entryVec.back();
-        const brlib::EntryBase& first = entryVec.front();
-        const QDate lastDt = dateFromEntry(last);
-        const QDate firstDt = dateFromEntry(first);
+        const QDate lastDt = dateFromDay(entries.day(entries.size() - 1));
+        const QDate firstDt = dateFromDay(entries.day(0));
         if (dtFrom->date() > firstDt)
         {
             dtFrom->setDate(firstDt);
@@ -51,6 +51,11 @@ namespace br_ui
             {
                 return alignmentData(section);
             }
+            else if (role == WidestTextRole && section >= ED_Date && section <= ED_Balance)
+            {
+                /* ED_ columns are in TableCols order */
+                return EntryStrings::column(m_strings.widest(), TableCols(section));
+            }
         }
         return ret;
     }
@@ -59,38 +64,32 @@ namespace br_ui
     {
         QVariant ret;
         if (!index.isValid() || !m_entries || m_entries->empty() || index.row() < 0 ||
-            index.row() >= static_cast<int>(m_entries->size()))
+            index.row() >= static_cast<int>(m_entries->size()) ||
+            index.row() >= static_cast<int>(m_strings.size()))
         {
             return ret;
         }
-        const brlib::EntryBase& entry = m_entries->at(index.row());
-        std::ostringstream oss{};
-        oss.imbue(std::cout.getloc());
+        const auto row = static_cast<brlib::entry_vec_sz_t>(index.row());
 
         if (role == Qt::DisplayRole)
         {
             switch (index.column())
             {
                 case ED_Date:
-                    entry.printDate(oss);
-                    break;
+                    return m_strings[row].date;
                 case ED_Narr:
-                    entry.printNarr(oss);
-                    break;
+                    return narrString(*m_entries, row);
                 case ED_Debit:
-                    entry.printDebit(oss);
-                    break;
+                    return m_strings[row].debit;
                 case ED_Credit:
-                    entry.printCredit(oss);
-                    break;
+                    return m_strings[row].credit;
                 case ED_Balance:
-                    entry.printBalance(oss);
-                    break;
+                    return m_strings[row].balance;
                 default:
                     qDebug() << "entrydatamodel data() default switch case index: " << index;
                     break;
             }
-            return QString(oss.str().data());
+            return ret;
         }
         else if (role == Qt::TextAlignmentRole)
         {
@@ -120,12 +119,18 @@ namespace br_ui
             removeRows(0, rows);
             endRemoveRows();
         }
+        m_strings.clear();
         if (!m_entries)
         {
             /* bail out in case of nullptr */
             endResetModel();
             return false;
         }
+        m_strings.reserve(m_entries->size());
+        for (brlib::entry_vec_sz_t i = 0; i < m_entries->size(); ++i)
+        {
+            m_strings.append(*m_entries, i, true);
+        }
         const int entryCount = static_cast<int>(m_entries->size());
         beginInsertRows(QModelIndex(), 0, entryCount - 1);
         insertRows(0, entryCount);
@@ -1,7 +1,10 @@
 #include <QPalette>
+#include <algorithm>
+#include <limits>
+#include <tuple>
 
-#include <EntryBase.h>
 #include <EntryMatch.h>
+#include <EntryStore.h>
 
 #include "EntryMatchModel.h"
 #include "helpers.h"
@@ -10,8 +13,8 @@ namespace br_ui
 {
     EntryMatchModel::EntryMatchModel(QObject* parent,
                                      vec<brlib::EntryMatch>* matches,
-                                     vec<brlib::EntryBase>* bankEntries,
-                                     vec<brlib::EntryBase>* booksEntries):
+                                     brlib::EntryStore* bankEntries,
+                                     brlib::EntryStore* booksEntries):
         QAbstractTableModel(parent),
         m_matches(matches),
         m_bankEntries(bankEntries), m_bookEntries(booksEntries) {}
@@ -22,7 +25,7 @@ namespace br_ui
         {
             return 0;
         }
-        return static_cast<int>(m_data.size());
+        return static_cast<int>(m_end - m_begin);
     }
 
     int EntryMatchModel::columnCount(const QModelIndex& parent) const
@@ -67,24 +70,37 @@ namespace br_ui
                     return {Qt::AlignVCenter | Qt::AlignLeft};
                 }
             }
+            else if (role == WidestTextRole)
+            {
+                switch (section)
+                {
+                    case EM_Date:
+                        return m_strings.widest().date;
+                    case EM_Debit:
+                        return m_strings.widest().debit;
+                    case EM_Credit:
+                        return m_strings.widest().credit;
+                    default:
+                        return ret;
+                }
+            }
         }
         return ret;
     }
 
-    brlib::EntryBase*
-      EntryMatchModel::entry(const brlib::EntryPointer& entryPtr) const
+    brlib::EntryStore*
+      EntryMatchModel::store(const brlib::EntryPointer& entryPtr) const
     {
-        brlib::entry_vec_sz_t entryIdx = entryPtr.entryIdx;
-        brlib::EntryBase* entry = nullptr;
+        brlib::EntryStore* entries = m_bookEntries;
         if (entryPtr.entryFor == brlib::EntryPointer::For::Bank)
         {
-            entry = &m_bankEntries->at(entryIdx);
+            entries = m_bankEntries;
         }
-        else
+        if (!entries || entryPtr.entryIdx >= entries->size())
         {
-            entry = &m_bookEntries->at(entryIdx);
+            return nullptr;
         }
-        return entry;
+        return entries;
     }
 
     QVariant EntryMatchModel::data(const QModelIndex& index, int role) const
@@ -93,61 +109,44 @@ namespace br_ui
         bool isDataUnavailable =
           m_data.empty() || !m_matches || (m_matches->empty()) || !m_bankEntries ||
           (m_bankEntries->empty()) || !m_bookEntries || (m_bookEntries->empty());
+        const std::size_t pos = m_begin + static_cast<std::size_t>(index.row());
         bool isIndexFromDataInvalid =
-          (index.row() >= m_data.size() || index.row() < 0);
+          (index.row() < 0 || pos >= m_end || pos >= m_strings.size());
         if (!index.isValid() || isDataUnavailable || isIndexFromDataInvalid)
         {
             return ret;
         }
 
-        auto entryFromIdx = [&]() -> brlib::EntryBase* {
-            const brlib::EntryPointer* ePtr = m_data.at(index.row());
-            if (!ePtr)
-            {
-                return nullptr;
-            }
-            return entry(*ePtr);
-        };
+        const brlib::EntryPointer* ePtr = m_data.at(pos);
+        const brlib::EntryStore* entries = ePtr ? store(*ePtr) : nullptr;
 
         if (role == Qt::DisplayRole)
         {
-            brlib::EntryBase* entry = entryFromIdx();
-            if (!entry)
+            if (!entries)
             {
                 return ret;
             }
-            std::ostringstream oss{""};
-            oss.imbue(std::cout.getloc());
+            static const QString bank = QStringLiteral("Bank"),
+                                 books = QStringLiteral("Books");
+            const EntryStrings::Row& row = m_strings[pos];
             switch (index.column())
             {
                 case EM_From:
-                    if (entry->entryFrom() == brlib::EntryBase::EntryFrom::Bank)
-                    {
-                        oss << "Bank";
-                    }
-                    else
-                    {
-                        oss << "Books";
-                    }
-                    break;
+                    return ePtr->entryFor == brlib::EntryPointer::For::Bank ? bank : books;
                 case EM_Date:
-                    entry->printDate(oss);
-                    break;
+                    return row.date;
                 case EM_Narr:
-                    entry->printNarr(oss);
-                    break;
+                    return narrString(*entries, ePtr->entryIdx);
                 case EM_Debit:
-                    entry->printDebit(oss);
-                    break;
+                    return row.debit;
                 case EM_Credit:
-                    entry->printCredit(oss);
-                    break;
+                    return row.credit;
                 default:
                     qDebug() << "matchedentrymodel data() default switch case index: "
                              << index;
                     break;
             }
-            return QString(oss.str().data());
+            return ret;
         }
         else if (role == Qt::TextAlignmentRole)
         {
@@ -167,9 +166,8 @@ namespace br_ui
         }
         else if (role == Qt::BackgroundRole)
         { /* bg color */
-            const brlib::EntryBase* entry = entryFromIdx();
             ret = QBrush(QColorConstants::DarkGray);
-            if (!entry)
+            if (!entries)
             {
                 return ret;
             }
@@ -181,12 +179,12 @@ namespace br_ui
             bankBg = QBrush(QColorConstants::Svg::slategray);
             booksBg = QBrush(QColorConstants::Svg::gray);
 #endif
-            switch (entry->entryFrom())
+            switch (ePtr->entryFor)
             {
-                case brlib::EntryBase::EntryFrom::Bank:
+                case brlib::EntryPointer::For::Bank:
                     ret = bankBg;
                     break;
-                case brlib::EntryBase::EntryFrom::Books:
+                case brlib::EntryPointer::For::Books:
                     ret = booksBg;
                     break;
                 default:
@@ -196,8 +194,7 @@ namespace br_ui
         }
         else if (role == Qt::ForegroundRole)
         {
-            const brlib::EntryBase* entry = entryFromIdx();
-            if (!entry)
+            if (!entries)
             {
                 return ret;
             }
@@ -224,68 +221,172 @@ namespace br_ui
     bool EntryMatchModel::updateVec(const QDate* from, const QDate* to)
     {
         beginResetModel();
-        const int rows = rowCount();
-        if (rows)
-        {
-            beginRemoveRows(QModelIndex(), 0, rows - 1);
-            removeRows(0, rows);
-            endRemoveRows();
-            m_data.clear();
-        }
+        m_data.clear();
+        m_strings.clear();
+        m_days.clear();
+        m_firstRows.clear();
+        m_begin = m_end = m_first = m_last = 0;
         if (!m_matches)
         {
             endResetModel();
             return false;
         }
-        const int matchesCount = static_cast<int>(m_matches->size());
-        if (matchesCount)
+        /* matches by the day of their earliest entry, so any date range is one
+         * run of matches; matches of one day stay in their order */
+        vec<std::pair<brlib::day_t, std::size_t>> order;
+        order.reserve(m_matches->size());
+        for (std::size_t m = 0; m < m_matches->size(); ++m)
         {
-            auto it = m_matches->cbegin();
-            while (it != m_matches->cend())
+            const brlib::day_t first = firstDay((*m_matches)[m]);
+            if (first != noDay)
             {
-                for (const brlib::EntryPointer& e : it->data())
+                order.emplace_back(first, m);
+            }
+        }
+        std::sort(order.begin(), order.end());
+
+        m_days.reserve(order.size());
+        m_firstRows.reserve(order.size() + 1);
+        for (const auto& [day, m] : order)
+        {
+            m_days.push_back(day);
+            m_firstRows.push_back(m_data.size());
+            for (const brlib::EntryPointer& e : (*m_matches)[m].data())
+            {
+                m_data.push_back(&e);
+                if (const brlib::EntryStore* entries = store(e))
                 {
-                    if (from && to)
-                    {
-                        const brlib::EntryBase* entr = entry(e);
-                        if (entr)
-                        {
-                            const QDate dt(dateFromEntry(*entr));
-                            if (*from <= dt && dt <= *to)
-                            {
-                                m_data.push_back(&e);
-                            }
-                        }
-                    }
-                    else
-                    {
-                        m_data.push_back(&e);
-                    }
+                    m_strings.append(*entries, e.entryIdx);
+                }
+                else
+                {
+                    m_strings.appendBlank();
                 }
-                ++it;
-                m_data.push_back(nullptr); // for separator blank row
             }
+            m_data.push_back(nullptr); // for separator blank row
+            m_strings.appendBlank();
+        }
+        m_firstRows.push_back(m_data.size());
+        m_bounds = dayBounds(from, to);
+        std::tie(m_first, m_last) = dayRange(m_days, m_bounds);
+        std::tie(m_begin, m_end) = rowsFor({m_first, m_last});
+        endResetModel();
+        return true;
+    }
 
-            /* resize the vector, as it will have unnecessary nullptr in the end.
-     * In case a date range is provided, it will have nullptrs to match
-     * m_matches.size() */
-            auto rIt = m_data.end();
+    void EntryMatchModel::setDateRange(const QDate* from, const QDate* to)
+    {
+        beginResetModel();
+        m_bounds = dayBounds(from, to);
+        std::tie(m_first, m_last) = dayRange(m_days, m_bounds);
+        std::tie(m_begin, m_end) = rowsFor({m_first, m_last});
+        endResetModel();
+    }
 
-            // end iterator pre incremented, dereferenced, and nullptr-checked
-            while (!*--rIt && rIt != m_data.begin())
+    void EntryMatchModel::appendMatch(std::size_t m)
+    {
+        if (!m_matches || m >= m_matches->size())
+        {
+            return;
+        }
+        const brlib::EntryMatch& match = (*m_matches)[m];
+        const brlib::day_t day = firstDay(match);
+        if (day == noDay)
+        {
+            return;
+        }
+        /* after the matches of its day, as updateVec orders them */
+        const std::size_t at =
+          static_cast<std::size_t>(std::upper_bound(m_days.begin(), m_days.end(), day) -
+                                   m_days.begin());
+        const std::size_t row = m_firstRows[at];
+        const std::size_t rows = match.data().size() + 1;
+        const bool shown = m_bounds.first <= day && day <= m_bounds.second;
+        if (shown)
+        {
+            /* the separator shown is the one between two matches shown */
+            std::size_t first = row - m_begin, count = rows;
+            if (m_first == m_last)
+            {
+                first = 0;
+                count = rows - 1;
+            }
+            else if (at == m_last)
             {
-                m_data.erase(rIt);
+                first -= 1;
             }
+            beginInsertRows(QModelIndex(), static_cast<int>(first),
+                            static_cast<int>(first + count - 1));
+        }
 
-            const int dataSize = static_cast<int>(m_data.size());
-            beginInsertRows(QModelIndex(), 0, dataSize - 1);
-            insertRows(0, dataSize);
+        std::size_t r = row;
+        for (const brlib::EntryPointer& e : match.data())
+        {
+            if (const brlib::EntryStore* entries = store(e))
+            {
+                m_strings.insert(r, *entries, e.entryIdx);
+            }
+            else
+            {
+                m_strings.insertBlank(r);
+            }
+            ++r;
+        }
+        m_strings.insertBlank(r);
+        vec<const brlib::EntryPointer*> matchRows;
+        matchRows.reserve(rows);
+        for (const brlib::EntryPointer& e : match.data())
+        {
+            matchRows.push_back(&e);
+        }
+        matchRows.push_back(nullptr); // for separator blank row
+        m_data.insert(m_data.begin() + row, matchRows.begin(), matchRows.end());
+        m_days.insert(m_days.begin() + at, day);
+        m_firstRows.insert(m_firstRows.begin() + at, row);
+        for (std::size_t i = at + 1; i < m_firstRows.size(); ++i)
+        {
+            m_firstRows[i] += rows;
+        }
+
+        if (shown)
+        {
+            ++m_last;
+        }
+        else if (day < m_bounds.first)
+        {
+            ++m_first;
+            ++m_last;
+        }
+        std::tie(m_begin, m_end) = rowsFor({m_first, m_last});
+        if (shown)
+        {
             endInsertRows();
-            endResetModel();
-            return true;
         }
-        endResetModel();
-        return true;
+    }
+
+    brlib::day_t EntryMatchModel::firstDay(const brlib::EntryMatch& match) const
+    {
+        brlib::day_t first = noDay;
+        for (const brlib::EntryPointer& e : match.data())
+        {
+            if (const brlib::EntryStore* entries = store(e))
+            {
+                first = std::min(first, entries->day(e.entryIdx));
+            }
+        }
+        return first;
+    }
+
+    std::pair<std::size_t, std::size_t>
+      EntryMatchModel::rowsFor(std::pair<std::size_t, std::size_t> matches) const
+    {
+        const auto [first, last] = matches;
+        if (first == last)
+        {
+            return {0, 0};
+        }
+        /* without the separator after the last match shown */
+        return {m_firstRows[first], m_firstRows[last] - 1};
     }
 
 } // namespace br_ui
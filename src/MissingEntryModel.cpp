@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
 #include "MissingEntryModel.h"
 #include "helpers.h"
 
@@ -5,7 +9,7 @@ namespace br_ui
 {
 
     MissingEntryModel::MissingEntryModel(QObject* parent,
-                                         vec<brlib::EntryBase>* entries,
+                                         brlib::EntryStore* entries,
                                          missing_t* missing):
         QAbstractTableModel(parent),
         m_entries(entries),
@@ -16,7 +20,7 @@ namespace br_ui
         if (parent.isValid() || !m_missingIndices || m_missingIndices->empty() ||
             m_data.empty())
             return 0;
-        return static_cast<int>(m_data.size());
+        return static_cast<int>(m_end - m_begin);
     }
 
     int MissingEntryModel::columnCount(const QModelIndex& parent) const
@@ -56,6 +60,10 @@ namespace br_ui
             {
                 ret = getCommonTextAlignment(section);
             }
+            else if (role == WidestTextRole && section >= Date && section <= Credit)
+            {
+                ret = EntryStrings::column(m_strings.widest(), TableCols(section));
+            }
         }
         return ret;
     }
@@ -67,8 +75,9 @@ namespace br_ui
         bool isDataUnavailable = !m_entries || (m_entries->empty()) ||
                                  !m_missingIndices || m_missingIndices->empty() ||
                                  m_data.empty();
+        const std::size_t pos = m_begin + static_cast<std::size_t>(index.row());
         bool isIndexFromDataInvalid =
-          (index.row() >= m_data.size()) || (index.row() < 0);
+          (index.row() < 0) || (pos >= m_end) || (pos >= m_strings.size());
         if (!index.isValid() || isDataUnavailable || isIndexFromDataInvalid)
         {
             return ret;
@@ -76,37 +85,28 @@ namespace br_ui
         try
         {
 
-            auto dataIndex = m_data.at(index.row());
-            const auto& entry =
-              static_cast<brlib::EntryBase&>(m_entries->at(dataIndex));
-            std::ostringstream oss{""};
-
-            /* at this point, std::cout has a locale with custom moneypunct
-     * (indian), so oss can imbue that locale  */
-            oss.imbue(std::cout.getloc());
-
+            auto dataIndex = m_data.at(pos);
+            if (dataIndex >= m_entries->size())
+            {
+                throw std::out_of_range("missing index past entries");
+            }
             if (role == Qt::DisplayRole)
             {
                 switch (index.column())
                 {
                     case Date:
-                        entry.printDate(oss);
-                        break;
-                    case Narr:
-                        entry.printNarr(oss);
-                        break;
                     case Credit:
-                        entry.printCredit(oss);
-                        break;
                     case Debit:
-                        entry.printDebit(oss);
-                        break;
+                        return EntryStrings::column(m_strings[pos],
+                                                    TableCols(index.column()));
+                    case Narr:
+                        return narrString(*m_entries, dataIndex);
                     default:
                         qDebug() << "missingentrymodel data() default switch case index: "
                                  << index;
                         break;
                 }
-                return QString(oss.str().data());
+                return ret;
             }
             else if (role == Qt::TextAlignmentRole)
             {
@@ -125,13 +125,10 @@ namespace br_ui
     bool MissingEntryModel::updateVec(const QDate* from, const QDate* to)
     {
         beginResetModel();
-        const int rows = rowCount();
-        if (rows)
-        {
-            beginRemoveRows(QModelIndex(), 0, rows - 1);
-            removeRows(0, rows);
-            endRemoveRows();
-        }
+        m_data.clear();
+        m_days.clear();
+        m_strings.clear();
+        m_begin = m_end = 0;
         if (!m_entries || !m_missingIndices)
         {
             /* bail out in case of nullptrs */
@@ -139,35 +136,93 @@ namespace br_ui
             qDebug() << "missingentrymodel updateVec() nullptrs received.";
             return false;
         }
-        m_data.clear();
-        for (const auto& i : *m_missingIndices)
+        /* by day, so any date range is one run of rows */
+        m_data = *m_missingIndices;
+        std::sort(m_data.begin(), m_data.end(),
+                  [this](brlib::entry_vec_sz_t lhs, brlib::entry_vec_sz_t rhs) {
+                      return before(lhs, rhs);
+                  });
+        m_days.reserve(m_data.size());
+        m_strings.reserve(m_data.size());
+        for (const brlib::entry_vec_sz_t i : m_data)
         {
-            if (from && to)
+            m_days.push_back(m_entries->day(i));
+            m_strings.append(*m_entries, i);
+        }
+        m_bounds = dayBounds(from, to);
+        std::tie(m_begin, m_end) = dayRange(m_days, m_bounds);
+        endResetModel();
+        return true;
+    }
+
+    void MissingEntryModel::setDateRange(const QDate* from, const QDate* to)
+    {
+        beginResetModel();
+        m_bounds = dayBounds(from, to);
+        std::tie(m_begin, m_end) = dayRange(m_days, m_bounds);
+        endResetModel();
+    }
+
+    void MissingEntryModel::removeEntries(const missing_t& entries)
+    {
+        if (!m_entries)
+        {
+            return;
+        }
+        vec<std::size_t> positions;
+        positions.reserve(entries.size());
+        for (const brlib::entry_vec_sz_t i : entries)
+        {
+            if (i >= m_entries->size())
             {
-                const brlib::EntryBase& e = m_entries->at(i);
-                const QDate dt(dateFromEntry(e));
-                if (*from <= dt && dt <= *to)
-                {
-                    m_data.push_back(i);
-                }
+                continue;
+            }
+            const auto it = std::lower_bound(
+              m_data.begin(), m_data.end(), i,
+              [this](brlib::entry_vec_sz_t lhs, brlib::entry_vec_sz_t rhs) {
+                  return before(lhs, rhs);
+              });
+            if (it != m_data.end() && *it == i)
+            {
+                positions.push_back(static_cast<std::size_t>(it - m_data.begin()));
+            }
+        }
+        /* last first, so the positions still to go stay put */
+        std::sort(positions.begin(), positions.end(), std::greater<>());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+        for (const std::size_t pos : positions)
+        {
+            const bool shown = m_begin <= pos && pos < m_end;
+            if (shown)
+            {
+                const int row = static_cast<int>(pos - m_begin);
+                beginRemoveRows(QModelIndex(), row, row);
             }
-            else
+            m_data.erase(m_data.begin() + pos);
+            m_days.erase(m_days.begin() + pos);
+            m_strings.erase(pos);
+            if (pos < m_begin)
             {
-                m_data.push_back(i);
+                --m_begin;
+                --m_end;
+            }
+            else if (shown)
+            {
+                --m_end;
+                endRemoveRows();
             }
         }
+    }
 
-        const int dataSize = static_cast<int>(m_data.size());
-        beginInsertRows(QModelIndex(), 0, dataSize - 1);
-        insertRows(0, dataSize);
-        endInsertRows();
-        endResetModel();
-        return true;
+    bool MissingEntryModel::before(brlib::entry_vec_sz_t lhs, brlib::entry_vec_sz_t rhs) const
+    {
+        const brlib::day_t l = m_entries->day(lhs), r = m_entries->day(rhs);
+        return l != r ? l < r : lhs < rhs;
     }
 
     brlib::entry_vec_sz_t
       MissingEntryModel::getIndex(const QModelIndex& idx) const
     {
-        return m_data.at(idx.row());
+        return m_data.at(m_begin + static_cast<std::size_t>(idx.row()));
     }
 } // namespace br_ui
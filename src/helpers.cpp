@@ -1,4 +1,13 @@
+#include <algorithm>
+#include <limits>
+
+#include <QFontMetrics>
+#include <QHeaderView>
+#include <QStyle>
+#include <QTableView>
+
 #include <EntryBase.h>
+#include <EntryStore.h>
 
 #include "brlib_common.h"
 #include "helpers.h"
@@ -41,11 +50,166 @@ namespace br_ui
         return ret;
     }
 
-    QDate dateFromEntry(const brlib::EntryBase& entry)
+    QDate dateFromDay(brlib::day_t day)
     {
-        const std::tm& t = entry.date;
+        const std::tm t = brlib::tmFromDays(day);
         const int &y = t.tm_year + 1900, &m = t.tm_mon + 1, &d = t.tm_mday;
         return {y, m, d};
     }
 
+    brlib::day_t dayFromDate(const QDate& date)
+    {
+        return brlib::daysFromCivil(date.year(), static_cast<unsigned>(date.month()),
+                                    static_cast<unsigned>(date.day()));
+    }
+
+    day_bounds_t dayBounds(const QDate* from, const QDate* to)
+    {
+        if (!from || !to)
+        {
+            return {std::numeric_limits<brlib::day_t>::min(),
+                    std::numeric_limits<brlib::day_t>::max()};
+        }
+        return {dayFromDate(*from), dayFromDate(*to)};
+    }
+
+    std::pair<std::size_t, std::size_t> dayRange(const vec<brlib::day_t>& days,
+                                                 day_bounds_t bounds)
+    {
+        /* empty when first > last: nothing from first on is <= last */
+        const auto begin = std::lower_bound(days.begin(), days.end(), bounds.first);
+        const auto end = std::upper_bound(begin, days.end(), bounds.second);
+        return {std::size_t(begin - days.begin()), std::size_t(end - days.begin())};
+    }
+
+    void fitColumns(QTableView* table, int sampleRows)
+    {
+        const QAbstractItemModel* model = table->model();
+        if (!model)
+        {
+            return;
+        }
+        const int rows = model->rowCount(), cols = model->columnCount();
+        vec<int> sample;
+        for (int r = 0; r < std::min(rows, sampleRows); ++r)
+        {
+            sample.push_back(r);
+        }
+        for (int r = std::max(sampleRows, rows - sampleRows); r < rows; ++r)
+        {
+            sample.push_back(r);
+        }
+
+        const QFontMetrics metrics(table->font());
+        /* the item delegate's text margins, and the grid line, as sizeHintForColumn */
+        const int margin =
+          2 * (table->style()->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, table) + 1) +
+          (table->showGrid() ? 1 : 0);
+        const QHeaderView* header = table->horizontalHeader();
+        for (int c = 0; c < cols; ++c)
+        {
+            if (table->isColumnHidden(c))
+            {
+                continue;
+            }
+            int width = header->sectionSizeHint(c);
+            auto measure = [&](const QVariant& text) {
+                width = std::max(width, metrics.horizontalAdvance(text.toString()) + margin);
+            };
+            measure(model->headerData(c, Qt::Horizontal, WidestTextRole));
+            for (const int r : sample)
+            {
+                measure(model->data(model->index(r, c), Qt::DisplayRole));
+            }
+            table->setColumnWidth(c, width);
+        }
+    }
+
+    QString narrString(const brlib::EntryStore& entries, brlib::entry_vec_sz_t i)
+    {
+        const std::string_view narr = entries.narr(i);
+        return QString::fromUtf8(narr.data(), static_cast<qsizetype>(narr.size()));
+    }
+
+    void EntryStrings::clear()
+    {
+        m_rows.clear();
+        m_widest = Row();
+        m_days.clear();
+    }
+
+    void EntryStrings::append(const brlib::EntryStore& entries, brlib::entry_vec_sz_t i,
+                              bool withBalance)
+    {
+        m_rows.push_back(format(entries, i, withBalance));
+    }
+
+    void EntryStrings::insert(std::size_t row, const brlib::EntryStore& entries,
+                              brlib::entry_vec_sz_t i, bool withBalance)
+    {
+        m_rows.insert(m_rows.begin() + row, format(entries, i, withBalance));
+    }
+
+    EntryStrings::Row EntryStrings::format(const brlib::EntryStore& entries,
+                                           brlib::entry_vec_sz_t i, bool withBalance)
+    {
+        Row row;
+        const brlib::day_t day = entries.day(i);
+        auto dayIt = m_days.constFind(day);
+        if (dayIt == m_days.cend())
+        {
+            char buf[brlib::displayChars];
+            const char* end = brlib::formatDay(day, buf);
+            dayIt = m_days.insert(day, QString::fromLatin1(buf, end - buf));
+        }
+        row.date = *dayIt;
+        row.debit = money(entries.debit(i));
+        row.credit = money(entries.credit(i));
+        if (withBalance)
+        {
+            row.balance = money(entries.balance(i));
+        }
+        for (QString Row::*col : {&Row::date, &Row::debit, &Row::credit, &Row::balance})
+        {
+            if ((row.*col).size() > (m_widest.*col).size())
+            {
+                m_widest.*col = row.*col;
+            }
+        }
+        return row;
+    }
+
+    QString EntryStrings::money(brlib::paise_t paise)
+    {
+        if (paise == 0)
+        {
+            if (m_zero.isEmpty())
+            {
+                m_zero = QStringLiteral("0.00");
+            }
+            return m_zero;
+        }
+        char buf[brlib::displayChars];
+        const char* end = brlib::formatMoney(paise, buf);
+        return QString::fromLatin1(buf, end - buf);
+    }
+
+    const QString& EntryStrings::column(const Row& row, TableCols col)
+    {
+        static const QString none;
+        switch (col)
+        {
+            case TableCols::Date:
+                return row.date;
+            case TableCols::Debit:
+                return row.debit;
+            case TableCols::Credit:
+                return row.credit;
+            case TableCols::Balance:
+                return row.balance;
+            default:
+                return none;
+        }
+    }
+
 } // namespace br_ui
\ No newline at end of file
@@ -116,21 +116,21 @@ namespace br_ui
             return currEntryMatch->insertIntoBooks(idx, m_results);
         };
 
-        auto getEntryFromRow = [&](const QModelIndex& idx, const SettingFor& sFor) {
+        auto getDebitFromRow = [&](const QModelIndex& idx, const SettingFor& sFor) {
             if (sFor == br_ui::SettingFor::Bank)
             {
                 const brlib::entry_vec_sz_t entryIdx = m_bankTableModel.getIndex(idx);
-                return m_bookVecs.passed->at(entryIdx);
+                return m_bookVecs.passed->debit(entryIdx);
             }
             else
             {
                 const brlib::entry_vec_sz_t entryIdx = m_bookTableModel.getIndex(idx);
-                return m_bankVecs.passed->at(entryIdx);
+                return m_bankVecs.passed->debit(entryIdx);
             }
         };
 
-        auto entrySide = [&](const brlib::EntryBase& entry) {
-            return !entry.debit ? SelectionState::Side::SelCredit : SelectionState::Side::SelDebit;
+        auto entrySide = [&](const brlib::paise_t debit) {
+            return !debit ? SelectionState::Side::SelCredit : SelectionState::Side::SelDebit;
         };
 
         /* selected rows of books entries [tblMisingInBank] */
@@ -143,11 +143,11 @@ namespace br_ui
         auto checkBankRows = [&]() {
             for (const QModelIndex& r : bankRows)
             {
-                const brlib::EntryBase entry = getEntryFromRow(r, SettingFor::Bank);
+                const brlib::paise_t debit = getDebitFromRow(r, SettingFor::Bank);
 
                 /* deselect the entry if it's not consistent with selection state, i.e.
        * inward vs outward */
-                if (entrySide(entry) != selState.side)
+                if (entrySide(debit) != selState.side)
                 {
                     deselectSelection(bankSelModel, r);
                     return;
@@ -171,8 +171,8 @@ namespace br_ui
         auto checkBooksRows = [&]() {
             for (const QModelIndex& r : booksRows)
             {
-                const brlib::EntryBase entry = getEntryFromRow(r, SettingFor::Books);
-                if (entrySide(entry) != selState.side)
+                const brlib::paise_t debit = getDebitFromRow(r, SettingFor::Books);
+                if (entrySide(debit) != selState.side)
                 {
                     deselectSelection(booksSelModel, r);
                     return;
@@ -206,10 +206,8 @@ namespace br_ui
                 {
                     /** init selection state from bankRows[0] */
 
-                    const brlib::EntryBase entry =
-                      getEntryFromRow(bankRows[0], SettingFor::Bank);
-                    const long& sum = entry.debit ? entry.debit : entry.credit;
-                    const SelectionState::Side side = entry.debit ? SelectionState::Side::SelDebit : SelectionState::Side::SelCredit;
+                    const SelectionState::Side side =
+                      entrySide(getDebitFromRow(bankRows[0], SettingFor::Bank));
                     updateSelState(SelectionState::Init::SelBank, side);
                 }
                 checkBankRows();
@@ -225,9 +223,8 @@ namespace br_ui
                 {
                     /** init selection state from booksRows[0] */
 
-                    const brlib::EntryBase entry =
-                      getEntryFromRow(booksRows[0], SettingFor::Books);
-                    const SelectionState::Side side = entry.debit ? SelectionState::Side::SelDebit : SelectionState::Side::SelCredit;
+                    const SelectionState::Side side =
+                      entrySide(getDebitFromRow(booksRows[0], SettingFor::Books));
                     updateSelState(SelectionState::Init::SelBooks, side);
                 }
                 checkBooksRows();
@@ -239,7 +236,8 @@ namespace br_ui
 
     void BR_MainWindow::updateBtnSaveMatch()
     {
-        if (currEntryMatch->isValid())
+        /* m_results belongs to the job while one runs */
+        if (!m_job && currEntryMatch->isValid())
             btnMatchSelected->setEnabled(true);
         else
             btnMatchSelected->setEnabled(false);
@@ -247,6 +245,10 @@ namespace br_ui
 
     void BR_MainWindow::btnSaveMatchClicked()
     {
+        if (m_job)
+        {
+            return;
+        }
         /** disconnect selectionChanged signals from tablemodels while we save an
    * entry match, and deselect selection */
         toggleSelectionConnections(false);
@@ -254,11 +256,18 @@ namespace br_ui
         deselectSelection(bankSelModel);
         deselectSelection(booksSelModel);
 
-        brlib::saveManualMatch(m_results, *currEntryMatch);
+        /* currEntryMatch.clearAll() called by saveManualMatch() */
+        const brlib::ManualMatchChange change = brlib::saveManualMatch(m_results, *currEntryMatch);
         updateMatchesText();
         toggleSelectionConnections();
-        /* currEntryMatch.clearAll() called by saveManualMatch() */
-        updateTablesData(true);
+        /* move just the matched rows; the missing lists themselves catch up at
+         * the next updateTablesData. m_bookTableModel shows bank entries. */
+        m_bookTableModel.removeEntries(change.bankRows);
+        m_bankTableModel.removeEntries(change.booksRows);
+        if (change.addedMatch)
+        {
+            m_matchesTableModel.appendMatch(*change.addedMatch);
+        }
         btnMatchSelected->setEnabled(false);
     }
 